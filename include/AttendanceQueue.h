@@ -11,17 +11,21 @@
 #include <SPIFFS.h>
 #include <ArduinoJson.h>
 #include "config.h"
+#include "CardUid.h"
+#include "Timestamp.h"
 
 // =============================================================================
 // ATTENDANCE RECORD
 // =============================================================================
 
 struct AttendanceRecord {
-    String uid;
+    CardUid uid;
     String name;
-    String timestamp;
+    Timestamp time;         // UTC; formatted only when uploaded/printed
     String attendanceStatus;
     String registrationStatus;
+    bool firstTapToday;     // Also write the /attendanceByDay rollup
+    bool pushed;            // /attendance confirmed, only the rollup is left
     String syncId;          // Tracking ID for Firebase sync
     int retryCount;         // Number of sync attempts
     unsigned long queuedAt; // When record was queued
@@ -53,8 +57,9 @@ public:
      * Add attendance record to queue
      * @return true if added successfully
      */
-    bool enqueue(String uid, String name, String timestamp,
-                 String attendanceStatus, String registrationStatus) {
+    bool enqueue(const CardUid& uid, String name, const Timestamp& time,
+                 String attendanceStatus, String registrationStatus,
+                 bool firstTapToday = false, bool pushed = false) {
         
         if (queue.size() >= MAX_QUEUE_SIZE) {
             Serial.println(F("⚠️ Queue full! Cannot add more records."));
@@ -64,9 +69,11 @@ public:
         AttendanceRecord record;
         record.uid = uid;
         record.name = name;
-        record.timestamp = timestamp;
+        record.time = time;
         record.attendanceStatus = attendanceStatus;
         record.registrationStatus = registrationStatus;
+        record.firstTapToday = firstTapToday;
+        record.pushed = pushed;
         record.syncId = "";
         record.retryCount = 0;
         record.queuedAt = millis();
@@ -74,7 +81,7 @@ public:
         queue.push_back(record);
         
         Serial.printf("📝 Queued: %s (Queue: %d/%d)\n",
-                     name.length() > 0 ? name.c_str() : uid.c_str(),
+                     name.length() > 0 ? name.c_str() : uid.toString().c_str(),
                      queue.size(), MAX_QUEUE_SIZE);
         
         // Check if approaching capacity
@@ -103,6 +110,26 @@ public:
         return &queue[index];
     }
     
+    /**
+     * Check for a record of this tap (journal replay dedupe)
+     */
+    bool contains(const CardUid& uid, uint32_t epoch) const {
+        for (const AttendanceRecord& record : queue) {
+            if (record.uid == uid && record.time.epoch == epoch) return true;
+        }
+        return false;
+    }
+    
+    /**
+     * Note that the first record's push landed (its rollup is still owed)
+     */
+    void markPushed() {
+        if (!queue.empty() && !queue[0].pushed) {
+            queue[0].pushed = true;
+            saveToSPIFFS();
+        }
+    }
+    
     /**
      * Update sync ID for first record
      */
@@ -120,7 +147,7 @@ public:
     bool dequeue() {
         if (queue.empty()) return false;
         
-        String name = queue[0].name.length() > 0 ? queue[0].name : queue[0].uid;
+        String name = queue[0].name.length() > 0 ? queue[0].name : queue[0].uid.toString();
         queue.erase(queue.begin());
         
         Serial.printf("✅ Dequeued: %s (Remaining: %d)\n", 
@@ -136,7 +163,7 @@ public:
     bool dequeueBySyncId(String syncId) {
         for (auto it = queue.begin(); it != queue.end(); ++it) {
             if (it->syncId == syncId) {
-                String name = it->name.length() > 0 ? it->name : it->uid;
+                String name = it->name.length() > 0 ? it->name : it->uid.toString();
                 queue.erase(it);
                 
                 Serial.printf("✅ Confirmed & dequeued: %s\n", name.c_str());
@@ -223,11 +250,14 @@ public:
         
         for (const auto& record : queue) {
             JsonObject obj = array.createNestedObject();
-            obj["uid"] = record.uid;
+            obj["uid"] = record.uid.toString();
             obj["name"] = record.name;
-            obj["timestamp"] = record.timestamp;
+            obj["t"] = record.time.epoch;
+            obj["ms"] = record.time.ms;
             obj["attendanceStatus"] = record.attendanceStatus;
             obj["registrationStatus"] = record.registrationStatus;
+            obj["firstTapToday"] = record.firstTapToday;
+            obj["pushed"] = record.pushed;
             obj["syncId"] = record.syncId;
             obj["retryCount"] = record.retryCount;
             obj["queuedAt"] = record.queuedAt;
@@ -266,14 +296,27 @@ public:
         
         queue.clear();
         JsonArray array = doc.as<JsonArray>();
+        int migrated = 0;
         
         for (JsonObject obj : array) {
             AttendanceRecord record;
-            record.uid = obj["uid"] | "";
+            if (!CardUid::fromHex(obj["uid"] | "", record.uid)) {
+                Serial.println(F("⚠️ Dropping queued record with invalid UID"));
+                continue;
+            }
             record.name = obj["name"] | "";
-            record.timestamp = obj["timestamp"] | "";
+            if (obj.containsKey("t")) {
+                record.time = Timestamp(obj["t"].as<uint32_t>(), obj["ms"].as<uint16_t>());
+            } else if (Timestamp::fromLegacyLocal(obj["timestamp"] | "", record.time)) {
+                migrated++;
+            } else {
+                Serial.println(F("⚠️ Dropping queued record with invalid timestamp"));
+                continue;
+            }
             record.attendanceStatus = obj["attendanceStatus"] | "present";
             record.registrationStatus = obj["registrationStatus"] | "registered";
+            record.firstTapToday = obj["firstTapToday"] | false;
+            record.pushed = obj["pushed"] | false;
             record.syncId = obj["syncId"] | "";
             record.retryCount = obj["retryCount"] | 0;
             record.queuedAt = obj["queuedAt"] | 0;
@@ -285,6 +328,12 @@ public:
             Serial.printf("📂 Loaded %d queued records\n", queue.size());
         }
         
+        // Rewrite ISO-string records as epoch once
+        if (migrated > 0) {
+            Serial.printf("🔄 Migrated %d queued records to epoch timestamps\n", migrated);
+            saveToSPIFFS();
+        }
+        
         return true;
     }
     
@@ -307,10 +356,13 @@ public:
                     break;
                 }
                 
+                char iso[TIMESTAMP_ISO_LEN];
+                record.time.toIso(iso);
                 Serial.printf("%d. %s - %s [%s]\n",
                              shown + 1,
-                             record.name.length() > 0 ? record.name.c_str() : record.uid.c_str(),
-                             record.timestamp.c_str(),
+                             record.name.length() > 0 ? record.name.c_str() : record.uid.toString().c_str(),
+                             iso,
+                             record.pushed ? "rollup only" :
                              record.syncId.length() > 0 ? "pending" : "queued");
                 shown++;
             }
@@ -0,0 +1,120 @@
+/*
+ * TapTrack - Card UID
+ * Fixed-size binary card UID used on the tap path.
+ * No heap use; hex text is produced only at the I/O edge
+ * (serial, SPIFFS JSON, Firebase paths/payloads).
+ */
+
+#ifndef CARD_UID_H
+#define CARD_UID_H
+
+#include <Arduino.h>
+#include <string.h>
+
+#define CARD_UID_MAX_BYTES      10      // ISO 14443-3 triple-size UID
+#define CARD_UID_HEX_LEN        (CARD_UID_MAX_BYTES * 2 + 1)
+
+// =============================================================================
+// CARD UID VALUE TYPE
+// =============================================================================
+
+struct CardUid {
+    uint8_t bytes[CARD_UID_MAX_BYTES];
+    uint8_t size;
+
+    CardUid() : size(0) {
+        memset(bytes, 0, sizeof(bytes));
+    }
+
+    CardUid(const uint8_t* data, uint8_t len) {
+        memset(bytes, 0, sizeof(bytes));
+        size = len > CARD_UID_MAX_BYTES ? CARD_UID_MAX_BYTES : len;
+        memcpy(bytes, data, size);
+    }
+
+    bool isEmpty() const {
+        return size == 0;
+    }
+
+    bool operator==(const CardUid& other) const {
+        return size == other.size && memcmp(bytes, other.bytes, size) == 0;
+    }
+
+    bool operator!=(const CardUid& other) const {
+        return !(*this == other);
+    }
+
+    /**
+     * Strict ordering (for std::map keys)
+     */
+    bool operator<(const CardUid& other) const {
+        if (size != other.size) return size < other.size;
+        return memcmp(bytes, other.bytes, size) < 0;
+    }
+
+    /**
+     * 32-bit FNV-1a hash of the UID bytes
+     */
+    uint32_t hash() const {
+        uint32_t h = 2166136261u;
+        for (uint8_t i = 0; i < size; i++) {
+            h = (h ^ bytes[i]) * 16777619u;
+        }
+        return h;
+    }
+
+    /**
+     * Write uppercase hex into buf
+     * @param buf - At least CARD_UID_HEX_LEN bytes
+     */
+    void toHex(char* buf) const {
+        static const char digits[] = "0123456789ABCDEF";
+        for (uint8_t i = 0; i < size; i++) {
+            buf[i * 2] = digits[bytes[i] >> 4];
+            buf[i * 2 + 1] = digits[bytes[i] & 0x0F];
+        }
+        buf[size * 2] = '\0';
+    }
+
+    /**
+     * Hex as a String (I/O edge only - allocates)
+     */
+    String toString() const {
+        char buf[CARD_UID_HEX_LEN];
+        toHex(buf);
+        return String(buf);
+    }
+
+    /**
+     * Parse hex text (either case) into a UID
+     * @return false if not an even-length hex string of 1..10 bytes
+     */
+    static bool fromHex(const char* hex, CardUid& out) {
+        size_t len = hex ? strlen(hex) : 0;
+        if (len == 0 || (len & 1) || len > CARD_UID_MAX_BYTES * 2) {
+            return false;
+        }
+
+        CardUid uid;
+        for (size_t i = 0; i < len; i++) {
+            char c = hex[i];
+            uint8_t nibble;
+            if (c >= '0' && c <= '9') nibble = c - '0';
+            else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+            else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+            else return false;
+
+            uid.bytes[i / 2] = (uid.bytes[i / 2] << 4) | nibble;
+        }
+        uid.size = len / 2;
+
+        out = uid;
+        return true;
+    }
+
+    static bool fromHex(const String& hex, CardUid& out) {
+        return fromHex(hex.c_str(), out);
+    }
+};
+
+#endif // CARD_UID_H
@@ -15,6 +15,9 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "Timestamp.h"
 
 // DS1302 Register Addresses
 #define DS1302_REG_SECONDS      0x80
@@ -26,6 +29,10 @@
 #define DS1302_REG_YEAR         0x8C
 #define DS1302_REG_WP           0x8E  // Write Protect
 #define DS1302_REG_BURST        0xBE  // Burst mode (read/write all)
+#define DS1302_REG_RAM_BURST    0xFE  // RAM burst (starts at RAM byte 0)
+
+// Battery-backed scratch RAM
+#define DS1302_RAM_SIZE         31
 
 // Read/Write flag
 #define DS1302_READ_FLAG        0x01
@@ -96,11 +103,44 @@ public:
      */
     void setRunning(bool running);
     
+    /**
+     * Read only the seconds register (cheap edge polling)
+     * @return Seconds 0-59
+     */
+    uint8_t getSeconds();
+    
+    /**
+     * Write the start of the battery-backed RAM in one burst
+     * @param data - Bytes for RAM 0..len-1
+     * @param len - 1..DS1302_RAM_SIZE
+     */
+    void writeRam(const uint8_t* data, uint8_t len);
+    
+    /**
+     * Read the start of the battery-backed RAM in one burst
+     * @param data - Receives RAM 0..len-1
+     * @param len - 1..DS1302_RAM_SIZE
+     */
+    void readRam(uint8_t* data, uint8_t len);
+    
+#ifdef TAPTRACK_BENCH
+    /**
+     * Time IO direction switches under the transfer lock (bench build)
+     * @param runs - Switches timed per method
+     * @param configUs - Receives the average gpio_config() switch
+     * @param fastUs - Receives the average enable register switch
+     */
+    void benchDirectionSwitch(int runs, float& configUs, float& fastUs);
+#endif
+    
 private:
     uint8_t _ioPin;
     uint8_t _sclkPin;
     uint8_t _cePin;
     
+    // Serializes bit-banged transfers (tap task reads, main loop syncs)
+    SemaphoreHandle_t _lock = nullptr;
+    
     /**
      * Start a transmission to the DS1302
      * @param address - Register address with R/W flag
@@ -172,10 +212,98 @@ extern const int daylightOffset_sec;
 // Global RTC instance
 extern DS1302_RTC rtc;
 
+// =============================================================================
+// SOFTWARE CLOCK
+// =============================================================================
+//
+// Taps read the time from RAM: the ESP32 system clock (esp_timer based,
+// set via settimeofday) holds UTC, and the DS1302 is only bit-banged at
+// boot and every RTC_RESYNC_INTERVAL_MS. A resync places the DS1302
+// seconds edge to within a loop pass by reading the seconds register once
+// per pass (never blocking), or predicts it from the last measurement,
+// then spins a few ms around the next edge to catch it to within
+// RTC_EDGE_MAX_GAP_US - the offset is known to well under a ms rather
+// than +/- 1 s.
+//
+// SNTP runs in the background (NTP_SYNC_INTERVAL_MS). Each answer is
+// handed to the main loop, which slews or steps the system clock, keeps
+// an offset history, estimates the system clock drift and rewrites the
+// DS1302 when it has wandered. While NTP is fresh the system clock is the
+// reference and DS1302 resyncs only measure its drift; once NTP goes
+// stale (NTP_HOLDOVER_MS) the DS1302 takes over, corrected by that drift.
+// getEpochMicros() adds the part of the last slew not applied yet and the
+// drift predicted since, and a correction folds both into its step/slew,
+// so timestamps do not jump back when it lands. Drift estimates live in
+// RAM and restart on reboot.
+
+typedef struct {
+    int64_t atUs;               // esp_timer time of the answer
+    int32_t offsetUs;           // NTP minus software clock
+} NtpSample;
+
+typedef struct {
+    // NTP
+    uint32_t ntpSyncCount;      // Answers applied
+    int32_t lastNtpOffsetUs;    // NTP minus software clock at the last answer
+    unsigned long lastNtpMs;    // millis() of the last answer
+    bool ntpFresh;              // System clock is the reference
+    float clockDriftPpm;        // Reference minus system clock rate (applied)
+    
+    // DS1302
+    uint32_t syncCount;         // Edges captured
+    uint32_t stepCount;         // Offsets too large to slew (either source)
+    uint32_t edgeTimeouts;      // Resyncs that found no usable edge
+    uint32_t rtcWrites;         // DS1302 rewritten from NTP time
+    uint32_t rtcWritesVerified; // Writes measured at the following edge
+    int32_t lastWriteOffsetUs;  // Where the last verified write landed
+    int32_t lastOffsetUs;       // DS1302 minus software clock at the last edge
+    uint32_t maxOffsetUs;       // Largest |offset| seen
+    float driftPpm;             // DS1302 rate error against NTP
+    uint32_t driftSamples;      // Edge pairs folded into driftPpm
+    uint32_t lastReadUs;        // Duration of the last DS1302 burst read
+    unsigned long lastSyncMs;   // millis() of the last captured edge
+} SoftClockStats;
+
+/**
+ * Set the system clock from the DS1302 (call after rtc.begin())
+ */
+void initSoftClock();
+
+/**
+ * Start background SNTP (no-op if already running; never blocks)
+ */
+void startNtpSync();
+
+/**
+ * Apply NTP answers, drive DS1302 resyncs and writes (main loop)
+ */
+void softClockLoop();
+
+/**
+ * Current UTC time in microseconds since the epoch (RAM only)
+ */
+int64_t getEpochMicros();
+
+/**
+ * Current time as epoch seconds + ms (RAM only)
+ */
+Timestamp getTimestamp();
+
+/**
+ * Local calendar fields of a timestamp
+ */
+DateTime toDateTime(const Timestamp& ts);
+
+/**
+ * Get resync and drift metrics
+ */
+SoftClockStats getSoftClockStats();
+
 /**
- * Initialize and sync RTC with NTP server
+ * Copy the NTP offset history, oldest first
+ * @return Number of samples copied
  */
-void setupAndSyncRTC();
+uint8_t getNtpHistory(NtpSample* out, uint8_t maxSamples);
 
 /**
  * Print DateTime in human-readable format
@@ -183,7 +311,7 @@ void setupAndSyncRTC();
 void printDateTime(const DateTime& dt);
 
 /**
- * Get current time from RTC
+ * Get current local time from the software clock
  * @return DateTime object with current time
  */
 DateTime getCurrentTime();
@@ -16,6 +16,8 @@
 #include <WiFiClientSecure.h>
 #include <FirebaseClient.h>
 #include "config.h"
+#include "CardUid.h"
+#include "Timestamp.h"
 #include "secrets.h"
 
 // =============================================================================
@@ -30,6 +32,15 @@ typedef enum {
     SYNC_FAILED
 } SyncStatus;
 
+typedef struct {
+    bool active;                    // Stream subscribed and healthy
+    unsigned long lastActivity;     // millis() of last event (incl. keep-alive)
+    unsigned long lastCatchupMs;    // Resubscribe -> full snapshot applied
+    int resubscribeCount;
+    int stallCount;
+    int retryCount;                 // Consecutive failed resubscribes
+} StreamHealth;
+
 typedef struct {
     SyncStatus status;
     String lastError;
@@ -37,19 +48,42 @@ typedef struct {
     int pendingCount;
     int successCount;
     int failCount;
+    unsigned long lastConfirmMs;    // Push -> server ack for last record
+    unsigned long maxConfirmMs;
+    unsigned long totalConfirmMs;   // Sum over successCount (for average)
 } SyncState;
 
+// =============================================================================
+// COMPACT SCHEMA CODES (ATTENDANCE_SCHEMA_VERSION 2)
+// =============================================================================
+
+typedef enum {
+    ATTENDANCE_CODE_PRESENT = 0,
+    ATTENDANCE_CODE_LATE    = 1
+} AttendanceCode;
+
+typedef enum {
+    REGISTRATION_CODE_REGISTERED   = 0,
+    REGISTRATION_CODE_UNREGISTERED = 1
+} RegistrationCode;
+
 // =============================================================================
 // EXTERNAL DECLARATIONS
 // =============================================================================
 
 extern UserAuth user_auth;
 extern FirebaseApp app;
-extern WiFiClientSecure ssl_client;
 extern DefaultNetwork network;
-extern AsyncClientClass aClient;
 extern RealtimeDatabase Database;
 
+// Long-lived /users SSE stream lives on its own client and socket
+extern WiFiClientSecure stream_ssl_client;
+extern AsyncClientClass streamClient;
+
+// Auth, reads and attendance/user writes share the write client
+extern WiFiClientSecure write_ssl_client;
+extern AsyncClientClass writeClient;
+
 extern SyncState syncState;
 
 // =============================================================================
@@ -82,18 +116,35 @@ bool isFirebaseAuthenticated();
 
 /**
  * Send attendance to Firebase
+ * Wire format follows ATTENDANCE_SCHEMA_VERSION (see config.h)
  * @return Sync ID for tracking (empty on immediate failure)
  */
-String sendToFirebase(String uid, String name, String timestamp, 
+String sendToFirebase(const CardUid& uid, String name, const Timestamp& time,
                       String attendanceStatus, String registrationStatus);
 
+#if ATTENDANCE_DAY_ROLLUP
+/**
+ * Create /attendanceByDay/<date>/<uid> for a user's first tap of the day
+ * Create-only: the database rules refuse an overwrite (see README), and
+ * that refusal confirms the sync, since the day is already recorded.
+ * Safe to resend until confirmed.
+ * @return Sync ID for tracking (empty on immediate failure)
+ */
+String sendDayRollup(const CardUid& uid, const Timestamp& time, String attendanceStatus);
+#endif
+
 /**
  * Check if a specific sync completed successfully
- * @param syncId - ID returned from sendToFirebase
+ * @param syncId - ID returned from sendToFirebase or sendDayRollup
  * @return true if confirmed, false if pending or failed
  */
 bool isSyncConfirmed(String syncId);
 
+/**
+ * Check if an attendance push or rollup is still awaiting its response
+ */
+bool isUploadInFlight();
+
 /**
  * Get last sync error message
  */
@@ -104,9 +155,18 @@ String getLastSyncError();
 // =============================================================================
 
 /**
- * Send pending user (unregistered card tap)
+ * Report an unregistered card tap
+ * The first tap of a UID is written right away (and its /users entry
+ * fetched once); repeats within PENDING_USER_WINDOW_MS only update the
+ * local table and are coalesced into the next batched flush.
+ */
+void reportPendingUser(const CardUid& uid, const Timestamp& time);
+
+/**
+ * Write coalesced pending-user updates as one multi-path update
+ * (call in loop while online; non-blocking)
  */
-void sendPendingUser(String uid, String timestamp);
+void flushPendingUsers();
 
 /**
  * Send registered user to Firebase
@@ -138,6 +198,25 @@ void stopUserStream();
  */
 bool isUserStreamActive();
 
+/**
+ * Stream supervisor (call in loop while online)
+ * Detects stalls and resubscribes with exponential backoff. Every
+ * resubscribe reconciles the local roster against the fresh snapshot,
+ * so adds/removals missed during the gap are caught up.
+ */
+void maintainUserStream();
+
+/**
+ * Drop the current stream and resubscribe immediately (e.g. after WiFi
+ * comes back and the old socket is known to be dead)
+ */
+void restartUserStream();
+
+/**
+ * Get stream supervisor statistics
+ */
+StreamHealth getStreamHealth();
+
 // =============================================================================
 // SYNC STATE
 // =============================================================================
@@ -0,0 +1,73 @@
+/*
+ * TapTrack - Latency Trace
+ * Tap-to-feedback timing from the card IRQ to the indicator
+ *
+ * Stages (esp_timer microseconds):
+ *   ISR -> UID read -> DB lookup -> decision -> indicator
+ *
+ * The IRQ and UID-read stamps arrive with each CardTap from the card
+ * task; the tap path (producer) stamps the rest and pushes finished
+ * traces into a lock-free single-producer/single-consumer ring, which
+ * the idle loop (consumer) drains into per-stage histograms for the
+ * `latency` command. Every card of a multi-card field is traced from
+ * the shared IRQ, so later cards include the wait behind earlier ones.
+ */
+
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// =============================================================================
+// TRACE POINTS
+// =============================================================================
+
+typedef enum {
+    TRACE_ISR,          // Card IRQ edge
+    TRACE_UID_READ,     // Anticollision/select done
+    TRACE_DB_LOOKUP,    // User cache lookup done
+    TRACE_DECISION,     // Online/offline/unregistered path chosen
+    TRACE_INDICATOR,    // LED/buzzer feedback fired (ends the trace)
+    TRACE_POINT_COUNT
+} TracePoint;
+
+// =============================================================================
+// FUNCTION DECLARATIONS
+// =============================================================================
+
+/**
+ * Open a trace for a tap
+ * @param irqUs - esp_timer stamp of the card IRQ
+ * @param uidReadUs - esp_timer stamp when the UID read finished
+ */
+void latencyTraceBegin(int64_t irqUs, int64_t uidReadUs);
+
+/**
+ * Stamp a trace point on the tap path
+ * No-op when no trace is open. TRACE_INDICATOR closes the trace and
+ * pushes it to the ring (dropped if the ring is full).
+ */
+void latencyTraceMark(TracePoint point);
+
+/**
+ * Abandon the open trace (tap ignored, e.g. duplicate)
+ */
+void latencyTraceCancel();
+
+/**
+ * Drain finished traces into the histograms (main loop)
+ */
+void latencyTraceCollect();
+
+/**
+ * Print p50/p95/p99 per stage and end to end
+ */
+void printLatencyStats();
+
+/**
+ * Clear histograms and drop counters
+ */
+void resetLatencyStats();
+
+#endif // LATENCY_TRACE_H
@@ -0,0 +1,95 @@
+/*
+ * TapTrack - Power Manager
+ * Idle power mode for battery / PoE-budgeted door units
+ *
+ * The MFRC522 has no low-power card detection: a card only raises the
+ * IRQ after answering a REQA. While idle with the radio off, the card
+ * task therefore duty-cycles: RF field on, settle, REQA, short wait for
+ * the IRQ, field off, then ESP32 light sleep for POWER_POLL_MS with the
+ * mode button and UART as extra wake sources. The card IRQ cannot wake
+ * the chip: with the field off no card answers, so cards are only found
+ * by the timer poll. Worst-case detection delay is
+ * POWER_POLL_MS + 2 * RFID_FIELD_SETTLE_MS.
+ *
+ * While online, Wi-Fi modem sleep (DTIM) stays on except while an
+ * attendance upload is awaiting its response.
+ *
+ * Residency and wake latency are tracked here; current draw has to be
+ * measured externally (shunt / USB power meter).
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// =============================================================================
+// POWER METRICS
+// =============================================================================
+
+typedef struct {
+    uint32_t sleepCount;
+    uint32_t timerWakeCount;
+    uint32_t gpioWakeCount;     // Mode button
+    uint32_t uartWakeCount;     // Serial input
+    uint64_t sleepTimeUs;       // Time spent in light sleep
+    uint64_t trackedTimeUs;     // Time since stats reset
+    uint32_t lastWakeLatencyUs; // Timer wake overshoot (sleep exit cost)
+    uint32_t maxWakeLatencyUs;
+    bool lowPowerIdle;          // Currently duty-cycling the card poll
+    bool modemSleep;            // Wi-Fi modem sleep enabled
+} PowerStats;
+
+// =============================================================================
+// FUNCTION DECLARATIONS
+// =============================================================================
+
+/**
+ * Configure light-sleep wake sources (mode button, UART)
+ */
+void initPower();
+
+/**
+ * Allow light sleep (main loop; true only while the radio is not needed)
+ */
+void setLowPowerAllowed(bool allowed);
+
+/**
+ * Restart the idle timer (tap, serial command, button press)
+ */
+void notePowerActivity();
+
+/**
+ * Check if the card task should duty-cycle and light sleep
+ */
+bool isPowerIdle();
+
+/**
+ * Enter light sleep until the timer or another wake source fires
+ * @param ms - Maximum sleep time
+ * @return esp_sleep_wakeup_cause_t of the wake
+ */
+uint32_t lightSleepFor(uint32_t ms);
+
+/**
+ * Switch Wi-Fi modem sleep off while an upload is in flight
+ */
+void setNetworkBusy(bool busy);
+
+/**
+ * Get residency / wake metrics
+ */
+PowerStats getPowerStats();
+
+/**
+ * Print residency and wake latency
+ */
+void printPowerStats();
+
+/**
+ * Clear residency and wake counters
+ */
+void resetPowerStats();
+
+#endif // POWER_MANAGER_H
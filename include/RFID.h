@@ -9,9 +9,44 @@
 #include <Arduino.h>
 #include <MFRC522.h>
 #include "config.h"
+#include "CardUid.h"
 
-// Global flag used by ISR
-extern volatile bool cardDetected;
+// =============================================================================
+// CARD TAPS
+// =============================================================================
+
+typedef struct {
+    CardUid uid;            // Empty = IRQ fired but no card could be read
+    int64_t detectedAtUs;   // esp_timer at the card IRQ
+    int64_t readAtUs;       // esp_timer when the UID read finished
+} CardTap;
+
+// =============================================================================
+// HEALTH METRICS
+// =============================================================================
+
+// Probe fault bits
+#define RFID_FAULT_VERSION      0x01    // VersionReg reads 0x00/0xFF (SPI or power)
+#define RFID_FAULT_IRQ_CONFIG   0x02    // ComIEnReg lost its value (chip reset itself)
+#define RFID_FAULT_ANTENNA      0x04    // TX1/TX2 drivers switched off
+#define RFID_FAULT_HEARTBEAT    0x08    // Idle REQA polling stopped raising TxIRq
+
+typedef struct {
+    uint32_t probeCount;
+    uint32_t probeFailCount;
+    uint32_t reinitCount;
+    uint32_t blindTimeMs;       // Total time spent reinitializing (taps missed)
+    unsigned long lastReinitAt;
+    uint8_t lastFaults;         // RFID_FAULT_* bits from last failed probe
+    uint32_t droppedTaps;       // Tap queue full
+    
+    // SPI time (esp_timer us)
+    uint32_t tapReadCount;
+    uint32_t lastTapReadUs;     // Field inventory + IRQ clear for the last tap
+    uint32_t maxTapReadUs;
+    uint64_t totalTapReadUs;
+    uint32_t lastPollUs;        // Idle REQA re-arm + health probe
+} RFIDStats;
 
 // =============================================================================
 // FUNCTION DECLARATIONS
@@ -22,11 +57,27 @@ extern volatile bool cardDetected;
  */
 void initRFID();
 
+/**
+ * Start the card task
+ * The task owns all MFRC522 SPI traffic: it re-arms REQA polling, runs
+ * the health probe, and on an IRQ notification reads every card in the
+ * field and posts one CardTap each. Call before attaching readCardISR.
+ */
+void startCardTask();
+
 /**
  * Interrupt service routine for card detection
+ * Stamps the IRQ time and notifies the card task
  */
 void IRAM_ATTR readCardISR();
 
+/**
+ * Take the next tap read by the card task
+ * @param wait - Ticks to block (0 = poll)
+ * @return true if a tap was returned
+ */
+bool takeCardTap(CardTap& tap, TickType_t wait = 0);
+
 /**
  * Activate receiver for card detection
  */
@@ -43,10 +94,19 @@ void clearInt();
 void enableInterrupt();
 
 /**
- * Read card UID as hex string
- * @return UID string (uppercase hex) or empty string on failure
+ * Read the UID of one card
+ * @return Card UID (empty on failure)
+ */
+CardUid readCardUID();
+
+/**
+ * Inventory every card in the field (anticollision + select + HALT per
+ * card, then REQA until no IDLE card answers)
+ * @param uids - Output array of card UIDs
+ * @param maxCards - Capacity of uids
+ * @return Number of cards read (0 on failure)
  */
-String readCardUID();
+uint8_t readCardUIDs(CardUid* uids, uint8_t maxCards);
 
 /**
  * Debug: dump byte array to serial
@@ -59,13 +119,21 @@ void dump_byte_array(byte *buffer, byte bufferSize);
 void clearUIDBuffer();
 
 /**
- * Periodic RFID module health check and reset
+ * Periodic RFID liveness probe (card task)
+ * Checks VersionReg, ComIEnReg, antenna drivers and the TxIRq heartbeat
+ * from activateRec(); reinitializes only after RFID_PROBE_FAIL_LIMIT
+ * consecutive failed probes.
  */
 void checkAndResetMFRC522();
 
+/**
+ * Get probe/reinit metrics
+ */
+RFIDStats getRFIDStats();
+
 /**
  * Check if RFID module is responsive
- * @return true if module responds correctly
+ * @return Result of the last liveness probe (no SPI traffic)
  */
 bool isRFIDHealthy();
 
@@ -0,0 +1,72 @@
+/*
+ * TapTrack - Reachability Probe
+ * Is the RTDB host reachable over the current Wi-Fi link?
+ *
+ * A probe is an lwIP DNS lookup (answered from the DNS cache most of the
+ * time) followed by a non-blocking TCP connect to the host's HTTPS port,
+ * reset right after the handshake - no TLS, no HTTP. Both steps are
+ * polled from the main loop, so a probe never blocks it.
+ *
+ * Link events drive the state: a link loss makes the host unreachable
+ * at once, a new link makes it reachable and probes immediately. While
+ * reachable the host is probed every REACH_PROBE_INTERVAL_MS (or on
+ * request after a failed upload); REACH_FAIL_LIMIT failures in a row,
+ * retried every REACH_RETRY_MS, mark it unreachable, and the first
+ * success marks it reachable again.
+ */
+
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// =============================================================================
+// REACHABILITY METRICS
+// =============================================================================
+
+typedef struct {
+    bool reachable;
+    uint32_t probes;
+    uint32_t failures;
+    uint32_t changes;               // Reachable <-> unreachable transitions
+    unsigned long lastProbeMs;      // DNS + connect time of the last probe
+    unsigned long lastChangeMs;     // millis() of the last transition
+} ReachabilityStats;
+
+// =============================================================================
+// FUNCTION DECLARATIONS
+// =============================================================================
+
+/**
+ * Set the probe target
+ * @param url - Database URL ("https://host[:port][/...]")
+ */
+void initReachability(const char* url);
+
+/**
+ * Wi-Fi link went up or down (call from the link callback)
+ */
+void setReachabilityLink(bool up);
+
+/**
+ * Probe as soon as possible (e.g. after an upload timeout)
+ */
+void requestReachabilityProbe();
+
+/**
+ * Advance the probe (main loop; never blocks)
+ */
+void reachabilityLoop();
+
+/**
+ * Check if the host answered the last probes
+ */
+bool isHostReachable();
+
+/**
+ * Get probe counters
+ */
+ReachabilityStats getReachabilityStats();
+
+#endif // REACHABILITY_H
@@ -0,0 +1,116 @@
+/*
+ * TapTrack - Tap Cooldown
+ * Per-UID duplicate-tap suppression with a fixed-size hash table
+ */
+
+#ifndef TAP_COOLDOWN_H
+#define TAP_COOLDOWN_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "CardUid.h"
+
+static_assert((TAP_COOLDOWN_SLOTS & (TAP_COOLDOWN_SLOTS - 1)) == 0,
+              "TAP_COOLDOWN_SLOTS must be a power of 2");
+
+// =============================================================================
+// COOLDOWN STATS
+// =============================================================================
+
+struct TapCooldownStats {
+    uint32_t checks;
+    uint32_t duplicates;     // Taps suppressed
+    uint32_t evictions;      // Live entries pushed out (table too small)
+    uint16_t occupancy;      // Entries still inside their cooldown
+};
+
+// =============================================================================
+// TAP COOLDOWN CLASS
+// =============================================================================
+
+/**
+ * Open-addressed table keyed by CardUid::hash()
+ * Each UID lives in one of TAP_COOLDOWN_PROBE slots after its home slot,
+ * so check/insert cost is constant. Entries expire lazily: a slot whose
+ * cooldown has passed counts as free. Only when every slot in the window
+ * is live does the least recently accepted one get evicted.
+ */
+class TapCooldown {
+private:
+    struct Slot {
+        CardUid uid;
+        unsigned long acceptedAt;
+        bool used;
+    };
+    
+    Slot slots[TAP_COOLDOWN_SLOTS] = {};
+    TapCooldownStats stats = {};
+    
+    bool isLive(const Slot& slot, unsigned long now) const {
+        return slot.used && (now - slot.acceptedAt) < TAP_COOLDOWN_MS;
+    }
+    
+public:
+    /**
+     * Check a tap and record it if accepted
+     * The cooldown runs from the last accepted tap, so repeated taps
+     * inside the window do not extend it.
+     * @return Remaining cooldown in ms if duplicate, 0 if accepted
+     */
+    unsigned long check(const CardUid& uid, unsigned long now) {
+        stats.checks++;
+        
+        uint32_t home = uid.hash() & (TAP_COOLDOWN_SLOTS - 1);
+        Slot* target = nullptr;
+        Slot* oldest = nullptr;
+        
+        for (uint8_t i = 0; i < TAP_COOLDOWN_PROBE; i++) {
+            Slot& slot = slots[(home + i) & (TAP_COOLDOWN_SLOTS - 1)];
+            
+            if (slot.used && slot.uid == uid) {
+                if (isLive(slot, now)) {
+                    stats.duplicates++;
+                    return TAP_COOLDOWN_MS - (now - slot.acceptedAt);
+                }
+                target = &slot;     // Expired entry for this UID - reuse it
+                break;
+            }
+            
+            if (!target && !isLive(slot, now)) {
+                target = &slot;
+            }
+            if (!oldest || (now - slot.acceptedAt) > (now - oldest->acceptedAt)) {
+                oldest = &slot;
+            }
+        }
+        
+        if (!target) {
+            target = oldest;
+            stats.evictions++;
+        }
+        
+        target->uid = uid;
+        target->acceptedAt = now;
+        target->used = true;
+        return 0;
+    }
+    
+    /**
+     * Count entries still inside their cooldown (full scan - stats only)
+     */
+    uint16_t occupancy(unsigned long now) const {
+        uint16_t live = 0;
+        for (const auto& slot : slots) {
+            if (isLive(slot, now)) live++;
+        }
+        return live;
+    }
+    
+    TapCooldownStats getStats(unsigned long now) const {
+        TapCooldownStats result = stats;
+        result.occupancy = occupancy(now);
+        return result;
+    }
+};
+
+#endif // TAP_COOLDOWN_H
@@ -0,0 +1,306 @@
+/*
+ * TapTrack - Tap Journal
+ * Crash-safe record of the last few accepted taps in the DS1302's
+ * battery-backed RAM. A tap is journaled (one burst write, under a
+ * millisecond) before the user gets feedback, and committed once it is
+ * in the SPIFFS queue or confirmed by Firebase. Taps still pending at
+ * boot were lost with the power and are replayed into the queue.
+ *
+ * RAM layout (31 bytes):
+ *   0      magic
+ *   1-30   3 slots x 10 bytes: uid[4], epoch[4] (LE),
+ *          tag (sequence number << 3 | flags), CRC-8 (Dallas/Maxim)
+ *
+ * A tap with sequence number n lives in slot n % 3; the newest tap is
+ * the valid slot with no successor. Each slot carries its own CRC, so a
+ * write torn by power loss only costs the slot being written - the
+ * other two are still replayed. Only 4-byte UIDs fit; longer UIDs skip
+ * the journal and are durable once queued, as before.
+ */
+
+#ifndef TAP_JOURNAL_H
+#define TAP_JOURNAL_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+#include "CardUid.h"
+#include "Timestamp.h"
+#include "DS1302_RTC.h"
+
+#define TAP_JOURNAL_MAGIC       0x7B    // Per-slot CRC layout
+#define TAP_JOURNAL_HEADER      1
+#define TAP_JOURNAL_SLOT_SIZE   10
+#define TAP_JOURNAL_SLOTS       3
+#define TAP_JOURNAL_UID_BYTES   4
+#define TAP_JOURNAL_TAG         8       // Slot offsets
+#define TAP_JOURNAL_CRC         9
+#define TAP_JOURNAL_SEQ_SHIFT   3
+#define TAP_JOURNAL_SEQ_WRAP    30      // Multiple of TAP_JOURNAL_SLOTS, fits the tag
+#define TAP_JOURNAL_NO_SEQ      0xFFFF  // Tap not journaled
+
+// Slot flags (low bits of the tag)
+#define TAP_JOURNAL_PENDING     0x01    // Not yet in flash or Firebase
+#define TAP_JOURNAL_LATE        0x02
+#define TAP_JOURNAL_FIRST_TODAY 0x04
+#define TAP_JOURNAL_FLAGS       0x07
+
+static_assert(TAP_JOURNAL_HEADER + TAP_JOURNAL_SLOTS * TAP_JOURNAL_SLOT_SIZE <= DS1302_RAM_SIZE,
+              "Tap journal does not fit in DS1302 RAM");
+static_assert(TAP_JOURNAL_SEQ_WRAP % TAP_JOURNAL_SLOTS == 0,
+              "TAP_JOURNAL_SEQ_WRAP must be a multiple of TAP_JOURNAL_SLOTS");
+static_assert(TAP_JOURNAL_SEQ_WRAP <= (0xFF >> TAP_JOURNAL_SEQ_SHIFT) + 1,
+              "TAP_JOURNAL_SEQ_WRAP does not fit the slot tag");
+
+// =============================================================================
+// JOURNAL ENTRY & STATS
+// =============================================================================
+
+struct TapJournalEntry {
+    uint16_t seq;
+    CardUid uid;
+    Timestamp time;
+    bool late;
+    bool firstTapToday;
+};
+
+struct TapJournalStats {
+    uint32_t appends;
+    uint32_t commits;
+    uint32_t overruns;      // Committed after its slot was reused (main loop far behind)
+    uint32_t skipped;       // UID too long for a slot
+    uint32_t recovered;     // Replayed at boot
+    uint32_t dropped;       // Torn slots discarded at boot
+    uint32_t lastWriteUs;   // Duration of the last RAM burst write
+    uint32_t maxWriteUs;
+    uint16_t seq;           // Newest sequence number
+};
+
+// =============================================================================
+// TAP JOURNAL CLASS
+// =============================================================================
+
+class TapJournal {
+private:
+    DS1302_RTC& rtc;
+    uint8_t ram[DS1302_RAM_SIZE] = {};
+    SemaphoreHandle_t lock = nullptr;
+    TapJournalStats stats = {};
+    uint16_t head = 0;      // Newest sequence number
+    bool ready = false;
+    
+    static uint8_t crc8(const uint8_t* data, uint8_t len) {
+        uint8_t crc = 0;
+        for (uint8_t i = 0; i < len; i++) {
+            uint8_t b = data[i];
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                uint8_t mix = (crc ^ b) & 0x01;
+                crc >>= 1;
+                if (mix) crc ^= 0x8C;
+                b >>= 1;
+            }
+        }
+        return crc;
+    }
+    
+    uint8_t* slot(uint16_t seq) {
+        return &ram[TAP_JOURNAL_HEADER + (seq % TAP_JOURNAL_SLOTS) * TAP_JOURNAL_SLOT_SIZE];
+    }
+    
+    static uint16_t slotSeq(const uint8_t* s) {
+        return s[TAP_JOURNAL_TAG] >> TAP_JOURNAL_SEQ_SHIFT;
+    }
+    
+    static uint16_t nextSeq(uint16_t seq) {
+        return (seq + 1) % TAP_JOURNAL_SEQ_WRAP;
+    }
+    
+    /**
+     * Slot intact and holding a sequence number that belongs there
+     */
+    bool slotValid(uint8_t index) {
+        const uint8_t* s = &ram[TAP_JOURNAL_HEADER + index * TAP_JOURNAL_SLOT_SIZE];
+        uint16_t seq = slotSeq(s);
+        return s[TAP_JOURNAL_CRC] == crc8(s, TAP_JOURNAL_CRC) &&
+               seq < TAP_JOURNAL_SEQ_WRAP && seq % TAP_JOURNAL_SLOTS == index;
+    }
+    
+    void seal(uint16_t seq, uint8_t flags) {
+        uint8_t* s = slot(seq);
+        s[TAP_JOURNAL_TAG] = (seq << TAP_JOURNAL_SEQ_SHIFT) | flags;
+        s[TAP_JOURNAL_CRC] = crc8(s, TAP_JOURNAL_CRC);
+    }
+    
+    /**
+     * Empty journal, every slot sealed with its own sequence number
+     */
+    void format() {
+        memset(ram, 0, sizeof(ram));
+        ram[0] = TAP_JOURNAL_MAGIC;
+        for (uint8_t i = 0; i < TAP_JOURNAL_SLOTS; i++) {
+            seal(i, 0);
+        }
+        head = TAP_JOURNAL_SLOTS - 1;
+        flush(head);
+    }
+    
+    /**
+     * Write RAM up to the end of the touched slot (a burst starts at 0)
+     */
+    void flush(uint16_t seq) {
+        uint8_t len = TAP_JOURNAL_HEADER + (seq % TAP_JOURNAL_SLOTS + 1) * TAP_JOURNAL_SLOT_SIZE;
+        int64_t start = esp_timer_get_time();
+        rtc.writeRam(ram, len);
+        stats.lastWriteUs = esp_timer_get_time() - start;
+        if (stats.lastWriteUs > stats.maxWriteUs) stats.maxWriteUs = stats.lastWriteUs;
+    }
+    
+public:
+    TapJournal(DS1302_RTC& rtc) : rtc(rtc) {}
+    
+    /**
+     * Load the journal (call once after rtc.begin())
+     * @param out - Receives up to TAP_JOURNAL_SLOTS taps to replay, oldest first
+     * @return Number of taps that were still pending
+     */
+    uint8_t begin(TapJournalEntry* out) {
+        if (!lock) lock = xSemaphoreCreateMutex();
+        
+        rtc.readRam(ram, DS1302_RAM_SIZE);
+        uint8_t count = 0;
+        
+        if (ram[0] != TAP_JOURNAL_MAGIC) {
+            format();
+            Serial.println(F("📓 Tap journal initialized"));
+            ready = true;
+            return 0;
+        }
+        
+        // Drop torn slots (power lost mid-write); only that slot is lost
+        bool valid[TAP_JOURNAL_SLOTS];
+        for (uint8_t i = 0; i < TAP_JOURNAL_SLOTS; i++) {
+            valid[i] = slotValid(i);
+            if (!valid[i]) {
+                Serial.printf("⚠️ Tap journal slot %u corrupt (power lost mid-write), dropped\n", i);
+                stats.dropped++;
+            }
+        }
+        
+        // The newest tap is the valid slot every other valid slot is older than
+        bool found = false;
+        for (uint8_t i = 0; i < TAP_JOURNAL_SLOTS && !found; i++) {
+            if (!valid[i]) continue;
+            
+            uint16_t seq = slotSeq(&ram[TAP_JOURNAL_HEADER + i * TAP_JOURNAL_SLOT_SIZE]);
+            found = true;
+            for (uint8_t j = 0; j < TAP_JOURNAL_SLOTS; j++) {
+                if (j == i || !valid[j]) continue;
+                uint16_t other = slotSeq(&ram[TAP_JOURNAL_HEADER + j * TAP_JOURNAL_SLOT_SIZE]);
+                if ((seq + TAP_JOURNAL_SEQ_WRAP - other) % TAP_JOURNAL_SEQ_WRAP >= TAP_JOURNAL_SLOTS) {
+                    found = false;
+                }
+            }
+            if (found) head = seq;
+        }
+        
+        if (!found) {
+            format();
+            Serial.println(F("⚠️ Tap journal unreadable, reset"));
+            ready = true;
+            return 0;
+        }
+        
+        for (int8_t back = TAP_JOURNAL_SLOTS - 1; back >= 0; back--) {
+            uint16_t seq = (head + TAP_JOURNAL_SEQ_WRAP - back) % TAP_JOURNAL_SEQ_WRAP;
+            uint8_t* s = slot(seq);
+            
+            if (!valid[seq % TAP_JOURNAL_SLOTS]) {
+                // Reseal it empty so it is not reported again
+                memset(s, 0, TAP_JOURNAL_SLOT_SIZE);
+                seal(seq, 0);
+                continue;
+            }
+            if (slotSeq(s) != seq || !(s[TAP_JOURNAL_TAG] & TAP_JOURNAL_PENDING)) continue;
+            
+            TapJournalEntry& entry = out[count++];
+            entry.seq = seq;
+            entry.uid = CardUid(s, TAP_JOURNAL_UID_BYTES);
+            entry.time = Timestamp(s[4] | (s[5] << 8) | (s[6] << 16) | ((uint32_t)s[7] << 24));
+            entry.late = s[TAP_JOURNAL_TAG] & TAP_JOURNAL_LATE;
+            entry.firstTapToday = s[TAP_JOURNAL_TAG] & TAP_JOURNAL_FIRST_TODAY;
+        }
+        
+        if (stats.dropped > 0) {
+            flush(TAP_JOURNAL_SLOTS - 1);
+        }
+        
+        stats.seq = head;
+        stats.recovered = count;
+        ready = true;
+        return count;
+    }
+    
+    /**
+     * Journal an accepted tap (tap task, before feedback)
+     * @return Sequence number to commit, or TAP_JOURNAL_NO_SEQ if skipped
+     */
+    uint16_t append(const CardUid& uid, const Timestamp& time, bool late, bool firstTapToday) {
+        if (!ready || uid.size != TAP_JOURNAL_UID_BYTES) {
+            stats.skipped++;
+            return TAP_JOURNAL_NO_SEQ;
+        }
+        
+        xSemaphoreTake(lock, portMAX_DELAY);
+        
+        uint16_t seq = nextSeq(head);
+        uint8_t* s = slot(seq);
+        
+        memcpy(s, uid.bytes, TAP_JOURNAL_UID_BYTES);
+        s[4] = time.epoch;
+        s[5] = time.epoch >> 8;
+        s[6] = time.epoch >> 16;
+        s[7] = time.epoch >> 24;
+        seal(seq, TAP_JOURNAL_PENDING |
+                  (late ? TAP_JOURNAL_LATE : 0) |
+                  (firstTapToday ? TAP_JOURNAL_FIRST_TODAY : 0));
+        head = seq;
+        
+        flush(seq);
+        stats.appends++;
+        stats.seq = seq;
+        
+        xSemaphoreGive(lock);
+        return seq;
+    }
+    
+    /**
+     * Mark a tap durable elsewhere (queued in SPIFFS or confirmed upload)
+     */
+    void commit(uint16_t seq) {
+        if (!ready || seq == TAP_JOURNAL_NO_SEQ) return;
+        
+        xSemaphoreTake(lock, portMAX_DELAY);
+        
+        // The slot must still hold this tap: a newer one in the same slot
+        // (the main loop fell TAP_JOURNAL_SLOTS taps behind) is left pending
+        uint16_t age = (head + TAP_JOURNAL_SEQ_WRAP - seq) % TAP_JOURNAL_SEQ_WRAP;
+        uint8_t* s = slot(seq);
+        if (age >= TAP_JOURNAL_SLOTS || slotSeq(s) != seq) {
+            stats.overruns++;
+        } else if (s[TAP_JOURNAL_TAG] & TAP_JOURNAL_PENDING) {
+            seal(seq, s[TAP_JOURNAL_TAG] & TAP_JOURNAL_FLAGS & ~TAP_JOURNAL_PENDING);
+            flush(seq);
+            stats.commits++;
+        }
+        
+        xSemaphoreGive(lock);
+    }
+    
+    TapJournalStats getStats() const {
+        return stats;
+    }
+};
+
+#endif // TAP_JOURNAL_H
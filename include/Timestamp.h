@@ -0,0 +1,112 @@
+/*
+ * TapTrack - Timestamp
+ * UTC epoch time carried through the tap path and the offline queue.
+ * Local (GMT_OFFSET_SEC) ISO text is produced only at the I/O edge
+ * (serial, Firebase payloads and paths).
+ */
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "config.h"
+
+#define TIMESTAMP_ISO_LEN       30      // "YYYY-MM-DDTHH:MM:SS.mmm+HH:MM" + NUL
+#define TIMESTAMP_DATE_LEN      11      // "YYYY-MM-DD" + NUL
+
+/**
+ * Civil date/time to epoch seconds (no TZ involved)
+ */
+inline int64_t civilToEpoch(int y, int mo, int d, int h, int mi, int s) {
+    y -= mo <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+
+    return days * 86400 + h * 3600 + mi * 60 + s;
+}
+
+// =============================================================================
+// TIMESTAMP VALUE TYPE
+// =============================================================================
+
+struct Timestamp {
+    uint32_t epoch;     // UTC seconds (0 = unset)
+    uint16_t ms;        // Milliseconds within the second
+
+    Timestamp() : epoch(0), ms(0) {}
+    Timestamp(uint32_t e, uint16_t m = 0) : epoch(e), ms(m) {}
+
+    bool isSet() const {
+        return epoch != 0;
+    }
+
+    /**
+     * Broken-down local time
+     */
+    struct tm local() const {
+        time_t t = (time_t)epoch + GMT_OFFSET_SEC;
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        return tm;
+    }
+
+    /**
+     * Write local ISO 8601 time with its UTC offset
+     * @param buf - At least TIMESTAMP_ISO_LEN bytes
+     */
+    void toIso(char* buf) const {
+        struct tm tm = local();
+        int offsetMin = GMT_OFFSET_SEC / 60;
+        char sign = offsetMin < 0 ? '-' : '+';
+        if (offsetMin < 0) offsetMin = -offsetMin;
+
+        snprintf(buf, TIMESTAMP_ISO_LEN, "%04d-%02d-%02dT%02d:%02d:%02d.%03u%c%02d:%02d",
+                 tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                 tm.tm_hour, tm.tm_min, tm.tm_sec, (unsigned)ms,
+                 sign, offsetMin / 60, offsetMin % 60);
+    }
+
+    /**
+     * Write the local date "YYYY-MM-DD"
+     * @param buf - At least TIMESTAMP_DATE_LEN bytes
+     */
+    void toLocalDate(char* buf) const {
+        struct tm tm = local();
+        snprintf(buf, TIMESTAMP_DATE_LEN, "%04d-%02d-%02d",
+                 tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    }
+
+    /**
+     * ISO text as a String (I/O edge only - allocates)
+     */
+    String toString() const {
+        char buf[TIMESTAMP_ISO_LEN];
+        toIso(buf);
+        return String(buf);
+    }
+
+    /**
+     * Parse a pre-epoch queue record timestamp
+     * Those were local time written as "YYYY-MM-DDTHH:MM:SS.000Z" (the Z
+     * was wrong), so the local offset is removed here.
+     * @return false if the text does not parse
+     */
+    static bool fromLegacyLocal(const char* text, Timestamp& out) {
+        int y, mo, d, h, mi, s;
+        if (!text || sscanf(text, "%d-%d-%dT%d:%d:%d", &y, &mo, &d, &h, &mi, &s) != 6) {
+            return false;
+        }
+
+        int64_t epoch = civilToEpoch(y, mo, d, h, mi, s) - GMT_OFFSET_SEC;
+        if (epoch <= 0 || epoch > UINT32_MAX) return false;
+
+        out = Timestamp((uint32_t)epoch);
+        return true;
+    }
+};
+
+#endif // TIMESTAMP_H
@@ -8,9 +8,12 @@
 
 #include <Arduino.h>
 #include <map>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <SPIFFS.h>
 #include <ArduinoJson.h>
 #include "config.h"
+#include "CardUid.h"
 
 // =============================================================================
 // USER INFO STRUCTURE
@@ -21,6 +24,7 @@ struct UserInfo {
     bool isRegistered;
     unsigned long lastSeen;  // Last tap timestamp
     int tapCount;            // Total taps
+    uint32_t lastPresentDay; // YYYYMMDD of last day marked present (0 = never)
 };
 
 // =============================================================================
@@ -29,10 +33,29 @@ struct UserInfo {
 
 class UserDatabase {
 private:
-    std::map<String, UserInfo> users;
+    std::map<CardUid, UserInfo> users;
     bool spiffsInitialized = false;
     bool dirty = false;  // Track if changes need to be saved
     
+    // Shared by the tap task (lookups, tap marks) and the network/storage
+    // loop (stream updates, saves); recursive so methods can nest
+    SemaphoreHandle_t lock = nullptr;
+    
+    struct Guard {
+        SemaphoreHandle_t m;
+        Guard(SemaphoreHandle_t m) : m(m) { if (m) xSemaphoreTakeRecursive(m, portMAX_DELAY); }
+        ~Guard() { if (m) xSemaphoreGiveRecursive(m); }
+    };
+    
+    /**
+     * Parse a hex UID coming from Firebase or SPIFFS (I/O edge)
+     */
+    static bool parseUid(const String& hex, CardUid& uid) {
+        if (CardUid::fromHex(hex, uid)) return true;
+        Serial.printf("⚠️ Ignoring invalid UID: %s\n", hex.c_str());
+        return false;
+    }
+    
 public:
     UserDatabase() {}
     
@@ -40,6 +63,7 @@ public:
      * Initialize database (call after SPIFFS is mounted)
      */
     bool init() {
+        if (!lock) lock = xSemaphoreCreateRecursiveMutex();
         if (spiffsInitialized) return true;
         spiffsInitialized = true;
         return loadFromSPIFFS();
@@ -48,8 +72,10 @@ public:
     /**
      * Register or update a user
      */
-    void registerUser(String uid, String name) {
-        uid.toUpperCase();
+    void registerUser(String uidHex, String name) {
+        Guard guard(lock);
+        CardUid uid;
+        if (!parseUid(uidHex, uid)) return;
         
         UserInfo info;
         
@@ -62,41 +88,56 @@ public:
             info.isRegistered = true;
             info.lastSeen = 0;
             info.tapCount = 0;
+            info.lastPresentDay = 0;
         }
         
         info.isRegistered = true;
         users[uid] = info;
         dirty = true;
         
-        Serial.printf("✓ Registered: %s (%s)\n", name.c_str(), uid.c_str());
+        Serial.printf("✓ Registered: %s (%s)\n", name.c_str(), uid.toString().c_str());
     }
     
     /**
      * Check if UID is registered
      */
-    bool isRegistered(String uid) {
-        uid.toUpperCase();
-        return users.count(uid) > 0 && users[uid].isRegistered;
+    bool isRegistered(const CardUid& uid) {
+        Guard guard(lock);
+        auto it = users.find(uid);
+        return it != users.end() && it->second.isRegistered;
+    }
+    
+    bool isRegistered(String uidHex) {
+        CardUid uid;
+        return CardUid::fromHex(uidHex, uid) && isRegistered(uid);
     }
     
     /**
      * Get user name
      */
-    String getName(String uid) {
-        uid.toUpperCase();
-        if (isRegistered(uid)) {
+    String getName(String uidHex) {
+        Guard guard(lock);
+        CardUid uid;
+        if (CardUid::fromHex(uidHex, uid) && isRegistered(uid)) {
             return users[uid].name;
         }
         return "";
     }
     
+    String getName(const CardUid& uid) {
+        Guard guard(lock);
+        auto it = users.find(uid);
+        return (it != users.end() && it->second.isRegistered) ? it->second.name : "";
+    }
+    
     /**
      * Get full user info
      */
-    UserInfo getUserInfo(String uid) {
-        uid.toUpperCase();
-        if (users.count(uid)) {
-            return users[uid];
+    UserInfo getUserInfo(const CardUid& uid) {
+        Guard guard(lock);
+        auto it = users.find(uid);
+        if (it != users.end()) {
+            return it->second;
         }
         
         UserInfo empty;
@@ -104,37 +145,77 @@ public:
         empty.isRegistered = false;
         empty.lastSeen = 0;
         empty.tapCount = 0;
+        empty.lastPresentDay = 0;
         return empty;
     }
     
     /**
      * Update last seen and tap count
      */
-    void recordTap(String uid) {
-        uid.toUpperCase();
-        if (users.count(uid)) {
-            users[uid].lastSeen = millis();
-            users[uid].tapCount++;
+    void recordTap(const CardUid& uid) {
+        Guard guard(lock);
+        auto it = users.find(uid);
+        if (it != users.end()) {
+            it->second.lastSeen = millis();
+            it->second.tapCount++;
             dirty = true;
         }
     }
     
+    /**
+     * Mark user present for a day
+     * @param day - Local date as YYYYMMDD
+     * @return true if this is the user's first mark for that day
+     */
+    bool markPresent(const CardUid& uid, uint32_t day) {
+        Guard guard(lock);
+        auto it = users.find(uid);
+        if (it == users.end() || it->second.lastPresentDay == day) {
+            return false;
+        }
+        it->second.lastPresentDay = day;
+        dirty = true;
+        return true;
+    }
+    
+    /**
+     * Check if user was already marked present on a day
+     */
+    bool isMarkedOn(const CardUid& uid, uint32_t day) {
+        Guard guard(lock);
+        auto it = users.find(uid);
+        return it != users.end() && it->second.lastPresentDay == day;
+    }
+    
+    /**
+     * Count users marked present on a day
+     */
+    int countMarkedOn(uint32_t day) {
+        Guard guard(lock);
+        int count = 0;
+        for (const auto& pair : users) {
+            if (pair.second.lastPresentDay == day) count++;
+        }
+        return count;
+    }
+    
     /**
      * Get user count
      */
     int getUserCount() {
+        Guard guard(lock);
         return users.size();
     }
     
     /**
      * Remove a user
      */
-    void unregisterUser(String uid) {
-        uid.toUpperCase();
-        if (users.count(uid)) {
-            users.erase(uid);
+    void unregisterUser(String uidHex) {
+        Guard guard(lock);
+        CardUid uid;
+        if (CardUid::fromHex(uidHex, uid) && users.erase(uid)) {
             dirty = true;
-            Serial.printf("🗑️ Unregistered: %s\n", uid.c_str());
+            Serial.printf("🗑️ Unregistered: %s\n", uidHex.c_str());
         }
     }
     
@@ -142,6 +223,7 @@ public:
      * Clear all users (but keep the file)
      */
     void clearAll() {
+        Guard guard(lock);
         users.clear();
         dirty = true;
         Serial.println(F("🗑️ All users cleared"));
@@ -151,17 +233,20 @@ public:
      * Print all registered users
      */
     void printAllUsers() {
+        Guard guard(lock);
         Serial.println(F("\n=== Registered Users ==="));
         
         if (users.empty()) {
             Serial.println(F("No users registered"));
         } else {
             int i = 1;
+            char hex[CARD_UID_HEX_LEN];
             for (const auto& pair : users) {
+                pair.first.toHex(hex);
                 Serial.printf("%d. %s (%s)\n", 
                              i++, 
                              pair.second.name.c_str(), 
-                             pair.first.c_str());
+                             hex);
             }
         }
         
@@ -173,9 +258,10 @@ public:
      * Get all UIDs as a vector
      */
     std::vector<String> getAllUIDs() {
+        Guard guard(lock);
         std::vector<String> uids;
         for (const auto& pair : users) {
-            uids.push_back(pair.first);
+            uids.push_back(pair.first.toString());
         }
         return uids;
     }
@@ -186,36 +272,57 @@ public:
     bool saveToSPIFFS() {
         if (!spiffsInitialized) return false;
         
+        // Snapshot under the lock; the flash write happens outside it so
+        // taps never wait on SPIFFS
+        String payload;
+        size_t count;
+        {
+            Guard guard(lock);
+            DynamicJsonDocument doc(JSON_BUFFER_LARGE);
+            JsonObject root = doc.to<JsonObject>();
+            
+            for (const auto& pair : users) {
+                JsonObject userObj = root.createNestedObject(pair.first.toString());
+                userObj["name"] = pair.second.name;
+                userObj["isRegistered"] = pair.second.isRegistered;
+                userObj["lastSeen"] = pair.second.lastSeen;
+                userObj["tapCount"] = pair.second.tapCount;
+                userObj["lastPresentDay"] = pair.second.lastPresentDay;
+            }
+            
+            serializeJson(doc, payload);
+            count = users.size();
+            dirty = false;
+        }
+        
         File file = SPIFFS.open(USER_DB_FILE_PATH, FILE_WRITE);
         if (!file) {
             Serial.println(F("❌ Failed to open user DB for writing"));
+            markDirty();
             return false;
         }
         
-        DynamicJsonDocument doc(JSON_BUFFER_LARGE);
-        JsonObject root = doc.to<JsonObject>();
-        
-        for (const auto& pair : users) {
-            JsonObject userObj = root.createNestedObject(pair.first);
-            userObj["name"] = pair.second.name;
-            userObj["isRegistered"] = pair.second.isRegistered;
-            userObj["lastSeen"] = pair.second.lastSeen;
-            userObj["tapCount"] = pair.second.tapCount;
-        }
-        
-        size_t written = serializeJson(doc, file);
+        size_t written = file.print(payload);
         file.close();
         
         if (written == 0) {
             Serial.println(F("❌ Failed to write user DB"));
+            markDirty();
             return false;
         }
         
-        dirty = false;
-        Serial.printf("💾 Saved %d users to SPIFFS\n", users.size());
+        Serial.printf("💾 Saved %d users to SPIFFS\n", count);
         return true;
     }
     
+    /**
+     * Flag unsaved changes (e.g. after a failed write)
+     */
+    void markDirty() {
+        Guard guard(lock);
+        dirty = true;
+    }
+    
     /**
      * Load from SPIFFS
      */
@@ -242,12 +349,13 @@ public:
             return false;
         }
         
+        Guard guard(lock);
         users.clear();
         JsonObject root = doc.as<JsonObject>();
         
         for (JsonPair kv : root) {
-            String uid = String(kv.key().c_str());
-            uid.toUpperCase();
+            CardUid uid;
+            if (!parseUid(String(kv.key().c_str()), uid)) continue;
             
             JsonObject userObj = kv.value().as<JsonObject>();
             
@@ -256,6 +364,7 @@ public:
             info.isRegistered = userObj["isRegistered"] | true;
             info.lastSeen = userObj["lastSeen"] | 0;
             info.tapCount = userObj["tapCount"] | 0;
+            info.lastPresentDay = userObj["lastPresentDay"] | 0;
             
             users[uid] = info;
         }
@@ -269,7 +378,7 @@ public:
      * Save if dirty
      */
     bool saveIfNeeded() {
-        if (dirty) {
+        if (isDirty()) {
             return saveToSPIFFS();
         }
         return true;
@@ -279,6 +388,7 @@ public:
      * Delete cache file
      */
     void clearCache() {
+        Guard guard(lock);
         if (spiffsInitialized && SPIFFS.exists(USER_DB_FILE_PATH)) {
             SPIFFS.remove(USER_DB_FILE_PATH);
         }
@@ -291,6 +401,7 @@ public:
      * Check if database has unsaved changes
      */
     bool isDirty() {
+        Guard guard(lock);
         return dirty;
     }
 };
@@ -25,6 +25,62 @@ struct WiFiConfig {
     bool configured;
 };
 
+// =============================================================================
+// STATION LINK STATE MACHINE
+// =============================================================================
+//
+// The station link is tracked from WiFi.onEvent (GOT_IP, DISCONNECTED,
+// LOST_IP) and driven by wifiLoop() from the main loop: a failed or
+// dropped link is retried with WiFi.begin() after WIFI_RECONNECT_MS,
+// doubling up to WIFI_RECONNECT_MAX_MS. Nothing here waits on the
+// radio except connectToWiFi(), which is used at boot and by the portal.
+//
+// The BSSID, channel and IP config of the last good link are cached in
+// Preferences. The first attempt after boot or a drop is a directed
+// connect to that AP on that channel with the cached IP (no scan, no
+// DHCP); if it fails, later attempts fall back to a full scan + DHCP.
+
+typedef enum {
+    WIFI_LINK_IDLE,         // Not managed (no credentials, or reconnect off)
+    WIFI_LINK_CONNECTING,   // WiFi.begin() issued, waiting for an IP
+    WIFI_LINK_CONNECTED,    // Associated and has an IP
+    WIFI_LINK_BACKOFF       // Waiting to retry
+} WiFiLinkState;
+
+typedef struct {
+    WiFiLinkState state;
+    uint32_t attempts;          // WiFi.begin() calls
+    uint32_t connects;          // GOT_IP events
+    uint32_t drops;             // Established links lost
+    uint32_t timeouts;          // Attempts that never got an IP
+    uint8_t lastReason;         // wifi_err_reason_t of the last disconnect
+    uint32_t backoffMs;         // Delay before the pending retry
+    uint32_t fastAttempts;      // Directed attempts from the link cache
+    uint32_t fastConnects;      // ... that got the link up
+    bool lastConnectFast;       // Last link came up through the cache
+    unsigned long lastConnectMs;    // WiFi.begin() -> GOT_IP of the last connect
+    unsigned long lastOnlineMs;     // Boot or link loss -> GOT_IP (time to online)
+    unsigned long lastChangeMs;     // millis() of the last up/down change
+} WiFiLinkStats;
+
+/**
+ * Last good link parameters (Preferences "wifi"/"link")
+ */
+typedef struct {
+    char ssid[33];              // Cache applies to this network only
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip;                // From DHCP, reused as a static config
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+} WiFiLinkCache;
+
+/**
+ * Link up/down callback, called from wifiLoop() (main loop context)
+ */
+typedef void (*WiFiLinkCallback)(bool connected);
+
 // =============================================================================
 // FUNCTION DECLARATIONS
 // =============================================================================
@@ -57,7 +113,8 @@ bool isPortalActive();
 void stopCaptivePortal();
 
 /**
- * Connect to WiFi with given credentials
+ * Connect to WiFi with given credentials, waiting for the result
+ * Boot and captive portal only - blocks for up to `timeout`.
  * @param ssid - Network SSID
  * @param password - Network password
  * @param timeout - Connection timeout in ms
@@ -65,8 +122,31 @@ void stopCaptivePortal();
  */
 bool connectToWiFi(String ssid, String password, uint32_t timeout = 20000);
 
+/**
+ * Run link retries and dispatch up/down changes (call from the main loop)
+ * Never blocks.
+ */
+void wifiLoop();
+
+/**
+ * Keep the station link up with saved credentials
+ * @param enabled - false stops retrying (an established link is kept)
+ */
+void setWiFiReconnect(bool enabled);
+
+/**
+ * Register the link up/down callback
+ */
+void setWiFiLinkCallback(WiFiLinkCallback callback);
+
+/**
+ * Get link state and counters
+ */
+WiFiLinkStats getWiFiLinkStats();
+
 /**
  * Save WiFi credentials to persistent storage
+ * Also caches the current link (BSSID, channel, IP config) if connected.
  */
 void saveWiFiCredentials(String ssid, String password);
 
@@ -103,7 +183,7 @@ int getWiFiSignalPercent();
 int getWiFiSignalBars();
 
 /**
- * Check if WiFi is connected
+ * Check if WiFi is connected (has an IP; event-driven, no radio access)
  */
 bool isWiFiConnected();
 
@@ -112,10 +192,4 @@ bool isWiFiConnected();
  */
 void disconnectWiFi();
 
-/**
- * Attempt to reconnect to WiFi
- * @return true if reconnected
- */
-bool reconnectWiFi();
-
 #endif // WIFIMANAGER_H
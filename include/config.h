@@ -39,21 +39,69 @@
 
 // Tap handling
 #define TAP_COOLDOWN_MS         30000   // 30 seconds between same card taps
+#define TAP_COOLDOWN_SLOTS      128     // Per-UID cooldown table size (power of 2)
+#define TAP_COOLDOWN_PROBE      8       // Slots searched per UID (bounds check cost)
+#define RFID_MAX_CARDS_PER_FIELD 4      // Cards inventoried per field activation
+#define TAP_JOURNAL             true    // Journal taps in DS1302 RAM before feedback
 
 // Sync intervals
 #define SYNC_INTERVAL_MS        30000   // Try to sync queue every 30 seconds
-#define WIFI_CHECK_INTERVAL_MS  60000   // Check WiFi every 60 seconds
-#define STREAM_RECONNECT_MS     30000   // Reconnect stream if disconnected
+
+// Wi-Fi station link (event-driven, see WifiManager.h)
+#define WIFI_CONNECT_TIMEOUT_MS 15000   // Attempt without an IP = failed
+#define WIFI_RECONNECT_MS       1000    // First retry delay (doubles per failure)
+#define WIFI_RECONNECT_MAX_MS   60000   // Retry backoff ceiling
+#define WIFI_FAST_CONNECT       true    // Directed connect to the cached BSSID/channel first
+#define WIFI_CACHED_IP          false   // ... with the cached DHCP lease as a static config (only with reserved leases)
+#define WIFI_FAST_TIMEOUT_MS    3000    // Directed attempt not associated = fall back to a scan (DHCP then gets WIFI_CONNECT_TIMEOUT_MS)
+
+// RTDB reachability probe (DNS + TCP connect, see Reachability.h)
+#define REACH_PROBE_INTERVAL_MS 15000   // Probe period while reachable
+#define REACH_RETRY_MS          1000    // Probe period after a failure
+#define REACH_PROBE_TIMEOUT_MS  2000    // DNS + connect budget per probe
+#define REACH_FAIL_LIMIT        2       // Failures in a row = unreachable
+
+// User stream supervisor
+#define STREAM_STALL_TIMEOUT_MS    60000   // No events (incl. keep-alive) = stalled
+#define STREAM_CONNECT_TIMEOUT_MS  15000   // Resubscribe must deliver a snapshot by then
+#define STREAM_RECONNECT_MS        2000    // First resubscribe delay (doubles per failure)
+#define STREAM_RECONNECT_MAX_MS    60000   // Resubscribe backoff ceiling
+
+// Unregistered card reporting
+#define PENDING_USER_WINDOW_MS  60000   // At most one /pendingUsers write per UID per window
+#define PENDING_USER_TABLE_SIZE 16      // Unknown UIDs tracked for coalescing
 
 // Captive portal
 #define PORTAL_TIMEOUT_MS       300000  // 5 minutes portal timeout
 
-// RFID module reset
-#define RFID_RESET_INTERVAL_MS  5000    // Reset MFRC522 every 5 seconds
+// RFID module health (reinit only when the probe says the chip is wedged)
+#define RFID_HEALTH_CHECK_MS       1000    // Liveness probe interval
+#define RFID_HEARTBEAT_TIMEOUT_MS  3000    // No TxIRq from idle REQA polling = wedged
+#define RFID_PROBE_FAIL_LIMIT      2       // Consecutive failed probes before reinit
+
+// Card task (owns the MFRC522; woken by the IRQ via task notification)
+#define RFID_TASK_PRIORITY      5       // Above the tap task and loopTask (1)
+#define RFID_TASK_STACK         4096
+#define RFID_TASK_CORE          1       // APP core; Wi-Fi/LwIP and loopTask run on core 0
+#define RFID_POLL_MS            10      // Idle REQA re-arm / health probe cadence
+#define RFID_TAP_QUEUE_LEN      8       // Card reads waiting for the tap task
+
+// Tap task (decision + feedback, APP core); hands off to the main loop
+#define TAP_TASK_PRIORITY       4
+#define TAP_TASK_STACK          6144
+#define TAP_TASK_CORE           1
+#define TAP_DECISION_QUEUE_LEN  16      // Decided taps waiting for upload/queueing
 
 // Debounce
 #define BUTTON_DEBOUNCE_MS      50      // Button debounce time
 
+// Idle power management (see PowerManager.h)
+#define POWER_LIGHT_SLEEP       true    // Light sleep between card polls while the radio is off
+#define POWER_MODEM_SLEEP       true    // Wi-Fi modem sleep while no sync is pending
+#define POWER_IDLE_AFTER_MS     30000   // No taps/commands/button presses = idle
+#define POWER_POLL_MS           100     // Card poll period while idle (worst-case detect delay)
+#define RFID_FIELD_SETTLE_MS    5       // RF field on -> REQA (PICC power-up, ISO 14443-3)
+
 // =============================================================================
 // ATTENDANCE CONFIGURATION
 // =============================================================================
@@ -79,6 +127,16 @@
 #define JSON_BUFFER_MEDIUM      4096    // Multiple records
 #define JSON_BUFFER_LARGE       8192    // Full sync
 
+// Attendance upload schema
+//   1 = verbose: uid, name, ISO timestamp, status strings (~150 B/record)
+//   2 = compact: {"v":2,"u":uid,"t":epoch,"a":code,"r":code} (~50 B/record)
+//       name is omitted - dashboards resolve it from /users/<uid>
+#define ATTENDANCE_SCHEMA_VERSION  1
+
+// Per-day rollup at /attendanceByDay/<YYYY-MM-DD>/<uid> (first tap only)
+#define ATTENDANCE_DAY_ROLLUP   true
+#define USER_DB_SAVE_INTERVAL_MS 60000  // Persist tap counts / present marks
+
 // SPIFFS file paths
 #define QUEUE_FILE_PATH         "/attendance_queue.json"
 #define USER_DB_FILE_PATH       "/user_database.json"
@@ -91,10 +149,12 @@
 #define BEEP_SUCCESS_MS         100     // Single short beep
 #define BEEP_ERROR_MS           200     // Error beep duration
 #define BEEP_ERROR_PAUSE_MS     100     // Pause between error beeps
+#define BEEP_LONG_MS            500     // Queue full / credentials cleared
 
 #define BLINK_FAST_MS           100     // Fast blink interval
 #define BLINK_SLOW_MS           500     // Slow blink interval
 #define BLINK_SYNC_MS           200     // Sync in progress blink
+#define BLINK_MODE_MS           1000    // AUTO mode blink
 
 #define INDICATOR_DISPLAY_MS    2000    // How long to show indicator after tap
 
@@ -106,6 +166,26 @@
 #define GMT_OFFSET_SEC          (8 * 3600)  // GMT+8 Philippines
 #define DAYLIGHT_OFFSET_SEC     0
 
+// Software clock (system time disciplined from the DS1302, see DS1302_RTC.h)
+#define RTC_RESYNC_INTERVAL_MS  600000  // Re-read the DS1302 every 10 min
+#define RTC_EDGE_TIMEOUT_MS     3000    // Give up the per-pass search for the DS1302 seconds phase
+#define RTC_EDGE_MAX_PASS_US    30000   // Ignore a tick seen across a longer loop pass
+#define RTC_EDGE_MAX_GAP_US     2000    // Ignore an edge seen across a longer poll gap
+#define RTC_EDGE_POLL_US        250     // Seconds register poll period while spinning
+#define RTC_EDGE_LEAD_US        10000   // Spin from this far ahead of a clock-predicted edge
+#define RTC_EDGE_MARGIN_US      2000    // Spin margin around an edge placed by the search
+#define RTC_EDGE_MAX_SPINS      3       // Missed spins per resync before waiting for the next
+#define RTC_STEP_THRESHOLD_US   500000  // Step the clock above this offset, slew below
+#define RTC_REWRITE_THRESHOLD_US 250000 // Rewrite the DS1302 from NTP time past this error
+#define RTC_WRITE_WINDOW_US     2000    // DS1302 writes land within this of a second boundary
+#define RTC_WRITE_LEAD_US       3000    // Longest wait for that boundary
+#define RTC_VERIFY_DELAY_MS     2000    // Measure where a DS1302 write landed this long after it
+
+// Background SNTP
+#define NTP_SYNC_INTERVAL_MS    3600000 // SNTP poll period (1 hour)
+#define NTP_HOLDOVER_MS         (3 * NTP_SYNC_INTERVAL_MS)  // Then the DS1302 is the reference again
+#define NTP_HISTORY_LEN         8       // NTP offsets kept for the `time` command
+
 // =============================================================================
 // SYSTEM MODES
 // =============================================================================
@@ -126,5 +206,10 @@ typedef enum {
 #define DEBUG_SERIAL            true    // Enable serial debug output
 #define DEBUG_FIREBASE          false   // Verbose Firebase logging
 #define DEBUG_RFID              false   // Verbose RFID logging
+#define DEBUG_RTC               false   // Log every DS1302 resync
+
+// Tap-to-feedback latency tracing (see `latency` command)
+#define LATENCY_TRACE           true    // Timestamp tap pipeline stages
+#define LATENCY_RING_SIZE       32      // Finished traces awaiting collection (power of 2)
 
 #endif // CONFIG_H
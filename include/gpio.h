@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "driver/gpio.h"
+#include "soc/gpio_struct.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,6 +26,39 @@ void gpio_write(uint8_t pin, uint8_t level);
 uint8_t gpio_read(uint8_t pin);
 void delay_us(uint32_t us);
 
+/*
+ * Fast path for bit-banged buses (DS1302)
+ * gpio_fast_init() runs gpio_config() once; after that, level and
+ * direction changes are single W1TS/W1TC register writes with the
+ * input buffer left enabled, so the pin can be read in either direction.
+ */
+void gpio_fast_init(uint8_t pin);
+
+static inline void gpio_fast_write(uint8_t pin, uint8_t level) {
+    if (pin < 32) {
+        if (level) GPIO.out_w1ts = 1UL << pin;
+        else       GPIO.out_w1tc = 1UL << pin;
+    } else {
+        if (level) GPIO.out1_w1ts.val = 1UL << (pin - 32);
+        else       GPIO.out1_w1tc.val = 1UL << (pin - 32);
+    }
+}
+
+static inline uint8_t gpio_fast_read(uint8_t pin) {
+    if (pin < 32) return (GPIO.in >> pin) & 0x1;
+    return (GPIO.in1.data >> (pin - 32)) & 0x1;
+}
+
+static inline void gpio_fast_output(uint8_t pin) {
+    if (pin < 32) GPIO.enable_w1ts = 1UL << pin;
+    else          GPIO.enable1_w1ts.val = 1UL << (pin - 32);
+}
+
+static inline void gpio_fast_input(uint8_t pin) {
+    if (pin < 32) GPIO.enable_w1tc = 1UL << pin;
+    else          GPIO.enable1_w1tc.val = 1UL << (pin - 32);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -35,7 +35,6 @@ typedef enum {
     IND_STATUS_SYNCING,         // Green blink (during sync)
     IND_STATUS_CONNECTING,      // Yellow blink (WiFi connecting)
     IND_STATUS_PORTAL_ACTIVE,   // Blue solid (captive portal)
-    IND_STATUS_STREAM_ACTIVE,   // Blue blink (Firebase stream active)
     
     // Mode indicators
     IND_MODE_ONLINE,            // Blue solid
@@ -62,20 +61,16 @@ typedef enum {
 void initIndicator();
 
 /**
- * Set indicator to specific state
+ * Set indicator to specific state (returns immediately)
+ * Timed states play on the foreground layer over the current
+ * mode/status pattern, which shows again when they end.
  * @param state - The indicator state to display
- * @param duration - How long to display (0 = until cleared)
+ * @param duration - How long to display (0 = background, until replaced or cleared)
  */
 void setIndicator(IndicatorState state, uint16_t duration = INDICATOR_DISPLAY_MS);
 
 /**
- * Update indicator (call in loop for blinking states)
- * Handles non-blocking blink patterns
- */
-void updateIndicator();
-
-/**
- * Clear all indicators
+ * Clear all indicators (every layer)
  */
 void clearIndicators();
 
@@ -97,6 +92,8 @@ void indicateMode(SystemMode mode);
 
 /**
  * Buzzer functions
+ * Non-blocking: played on their own layer, a new beep replaces one
+ * still playing
  */
 void beep(uint16_t duration);
 void beepSuccess();
@@ -110,7 +107,7 @@ void beepLong();
 void testIndicators();
 
 /**
- * Startup animation sequence
+ * Startup animation sequence (returns immediately)
  */
 void startupSequence();
 
@@ -4,7 +4,11 @@
  */
 
 #include "DS1302_RTC.h"
+#include "config.h"
 #include "gpio.h"
+#include <sys/time.h>
+#include <esp_timer.h>
+#include <esp_sntp.h>
 
 // =============================================================================
 // NTP CONFIGURATION
@@ -32,10 +36,12 @@ DS1302_RTC::DS1302_RTC(uint8_t ioPin, uint8_t sclkPin, uint8_t cePin)
  * Initialize the RTC
  */
 void DS1302_RTC::begin() {
-    // Set pins to default state (low, input)
-    gpio_pin_init(_cePin, GPIO_INPUT_MODE);
-    gpio_pin_init(_sclkPin, GPIO_INPUT_MODE);
-    gpio_pin_init(_ioPin, GPIO_INPUT_MODE);
+    if (!_lock) _lock = xSemaphoreCreateMutex();
+    
+    // Configure pins once (low, input); transfers only flip registers
+    gpio_fast_init(_cePin);
+    gpio_fast_init(_sclkPin);
+    gpio_fast_init(_ioPin);
     
     // Disable write protection to allow configuration
     setWriteProtect(false);
@@ -50,6 +56,8 @@ void DS1302_RTC::begin() {
  * Set date and time
  */
 void DS1302_RTC::setDateTime(const DateTime& dt) {
+    if (_lock) xSemaphoreTake(_lock, portMAX_DELAY);
+    
     // Disable write protection
     setWriteProtect(false);
     
@@ -82,6 +90,8 @@ void DS1302_RTC::setDateTime(const DateTime& dt) {
     writeByte(0x00);
     
     endTransmission();
+    
+    if (_lock) xSemaphoreGive(_lock);
 }
 
 /**
@@ -90,6 +100,8 @@ void DS1302_RTC::setDateTime(const DateTime& dt) {
 DateTime DS1302_RTC::getDateTime() {
     DateTime dt;
     
+    if (_lock) xSemaphoreTake(_lock, portMAX_DELAY);
+    
     // Use burst mode to read all registers at once
     beginTransmission(DS1302_REG_BURST | DS1302_READ_FLAG);
     
@@ -119,6 +131,8 @@ DateTime DS1302_RTC::getDateTime() {
     
     endTransmission();
     
+    if (_lock) xSemaphoreGive(_lock);
+    
     return dt;
 }
 
@@ -145,23 +159,96 @@ void DS1302_RTC::setRunning(bool running) {
     writeRegister(DS1302_REG_SECONDS, seconds);
 }
 
+/**
+ * Read the seconds register
+ */
+uint8_t DS1302_RTC::getSeconds() {
+    if (_lock) xSemaphoreTake(_lock, portMAX_DELAY);
+    uint8_t seconds = readRegister(DS1302_REG_SECONDS);
+    if (_lock) xSemaphoreGive(_lock);
+    
+    return bcdToDec(seconds & 0x7F);
+}
+
+/**
+ * Burst-write RAM (a RAM burst may stop early, unlike the clock burst)
+ */
+void DS1302_RTC::writeRam(const uint8_t* data, uint8_t len) {
+    if (len > DS1302_RAM_SIZE) len = DS1302_RAM_SIZE;
+    
+    if (_lock) xSemaphoreTake(_lock, portMAX_DELAY);
+    
+    setWriteProtect(false);
+    beginTransmission(DS1302_REG_RAM_BURST);
+    for (uint8_t i = 0; i < len; i++) {
+        writeByte(data[i]);
+    }
+    endTransmission();
+    
+    if (_lock) xSemaphoreGive(_lock);
+}
+
+/**
+ * Burst-read RAM
+ */
+void DS1302_RTC::readRam(uint8_t* data, uint8_t len) {
+    if (len > DS1302_RAM_SIZE) len = DS1302_RAM_SIZE;
+    
+    if (_lock) xSemaphoreTake(_lock, portMAX_DELAY);
+    
+    beginTransmission(DS1302_REG_RAM_BURST | DS1302_READ_FLAG);
+    for (uint8_t i = 0; i < len; i++) {
+        data[i] = readByte();
+    }
+    endTransmission();
+    
+    if (_lock) xSemaphoreGive(_lock);
+}
+
+#ifdef TAPTRACK_BENCH
+/**
+ * Bench IO direction switches
+ * The IO pin is the live bus, so a tap task read must not run in between.
+ */
+void DS1302_RTC::benchDirectionSwitch(int runs, float& configUs, float& fastUs) {
+    if (_lock) xSemaphoreTake(_lock, portMAX_DELAY);
+    
+    unsigned long start = micros();
+    for (int i = 0; i < runs; i++) {
+        gpio_pin_init(_ioPin, GPIO_INPUT_MODE);
+    }
+    configUs = (micros() - start) / (float)runs;
+    
+    start = micros();
+    for (int i = 0; i < runs; i++) {
+        gpio_fast_input(_ioPin);
+    }
+    fastUs = (micros() - start) / (float)runs;
+    
+    // Back to the state begin() left it in (low, input)
+    gpio_fast_init(_ioPin);
+    
+    if (_lock) xSemaphoreGive(_lock);
+}
+#endif
+
 /**
  * Begin transmission
  */
 void DS1302_RTC::beginTransmission(uint8_t address) {
     // Set CE low first
-    gpio_write(_cePin, 0);
-    gpio_pin_init(_cePin, GPIO_OUTPUT_MODE);
+    gpio_fast_write(_cePin, 0);
+    gpio_fast_output(_cePin);
     
     // Set SCLK low
-    gpio_write(_sclkPin, 0);
-    gpio_pin_init(_sclkPin, GPIO_OUTPUT_MODE);
+    gpio_fast_write(_sclkPin, 0);
+    gpio_fast_output(_sclkPin);
     
     // Set IO as output
-    gpio_pin_init(_ioPin, GPIO_OUTPUT_MODE);
+    gpio_fast_output(_ioPin);
     
     // Enable the chip (CE high)
-    gpio_write(_cePin, 1);
+    gpio_fast_write(_cePin, 1);
     delayMicroseconds(4);  // tCC = 4us
     
     // Send the address/command byte
@@ -173,13 +260,13 @@ void DS1302_RTC::beginTransmission(uint8_t address) {
  */
 void DS1302_RTC::endTransmission() {
     // Disable the chip (CE low)
-    gpio_write(_cePin, 0);
+    gpio_fast_write(_cePin, 0);
     delayMicroseconds(4);  // tCWH = 4us
     
     // Reset pins to input (low power state)
-    gpio_pin_init(_cePin, GPIO_INPUT_MODE);
-    gpio_pin_init(_sclkPin, GPIO_INPUT_MODE);
-    gpio_pin_init(_ioPin, GPIO_INPUT_MODE);
+    gpio_fast_input(_cePin);
+    gpio_fast_input(_sclkPin);
+    gpio_fast_input(_ioPin);
 }
 
 /**
@@ -188,20 +275,20 @@ void DS1302_RTC::endTransmission() {
 void DS1302_RTC::writeByte(uint8_t data, bool isRead) {
     for (uint8_t i = 0; i < 8; i++) {
         // Set data bit
-        gpio_write(_ioPin, data & 0x01);
+        gpio_fast_write(_ioPin, data & 0x01);
         delayMicroseconds(1);  // tDC = 200ns
         
         // Clock high (DS1302 reads on rising edge)
-        gpio_write(_sclkPin, 1);
+        gpio_fast_write(_sclkPin, 1);
         delayMicroseconds(1);  // tCH = 1000ns
         
         // If this is the last bit before a read, switch IO to input
         if (i == 7 && isRead) {
-            gpio_pin_init(_ioPin, GPIO_INPUT_MODE);
+            gpio_fast_input(_ioPin);
         }
         
         // Clock low
-        gpio_write(_sclkPin, 0);
+        gpio_fast_write(_sclkPin, 0);
         delayMicroseconds(1);  // tCL = 1000ns
         
         // Shift to next bit
@@ -217,14 +304,14 @@ uint8_t DS1302_RTC::readByte() {
     
     for (uint8_t i = 0; i < 8; i++) {
         // Read bit (LSB first)
-        data |= (gpio_read(_ioPin) << i);
+        data |= (gpio_fast_read(_ioPin) << i);
         
         // Clock high
-        gpio_write(_sclkPin, 1);
+        gpio_fast_write(_sclkPin, 1);
         delayMicroseconds(1);
         
         // Clock low (data is ready after this)
-        gpio_write(_sclkPin, 0);
+        gpio_fast_write(_sclkPin, 0);
         delayMicroseconds(1);  // tCL = 1000ns, tCDD = 800ns
     }
     
@@ -275,38 +362,560 @@ uint8_t DS1302_RTC::bcdToDec(uint8_t val) {
 }
 
 // =============================================================================
-// NTP SYNC AND UTILITY FUNCTIONS
+// SOFTWARE CLOCK
 // =============================================================================
 
+typedef enum {
+    RESYNC_IDLE,
+    RESYNC_FIND_PHASE,      // One seconds-register read per loop pass
+    RESYNC_WAIT_EDGE        // Edge placed; spin around it when it is due
+} ResyncState;
+
+// Shared with the tap task (getEpochMicros)
+static portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t lastCorrectionUs = 0;    // esp_timer time of the last clock correction
+static float predictPpm = 0;            // Drift applied since then
+static volatile uint32_t clockSeq = 0;  // Odd while a correction is being applied
+
+// Handed over by the SNTP task
+static portMUX_TYPE ntpMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool ntpPending = false;
+static int64_t ntpTimeUs = 0;           // UTC from the answer
+static int64_t ntpAtUs = 0;             // esp_timer time it arrived
+
+// Main loop only
+static NtpSample ntpHistory[NTP_HISTORY_LEN];
+static uint8_t ntpHistoryHead = 0;
+static uint8_t ntpHistoryCount = 0;
+static bool clockDriftSeeded = false;
+
+static ResyncState resyncState = RESYNC_IDLE;
+static unsigned long resyncStartedAt = 0;
+static int64_t edgeDueUs = 0;           // esp_timer time the next edge is expected
+static int64_t edgeLeadUs = 0;          // Its uncertainty (spin from edgeDueUs minus this)
+static bool edgePredictable = false;    // The last spin caught an edge
+static uint8_t edgeAttempts = 0;        // Windows tried this resync
+static unsigned long phaseStartedAt = 0;
+static int64_t phasePollUs = 0;
+static uint8_t phaseSecond = 0;
+
+// Last known DS1302 error (DS1302 minus true time)
+static int64_t rtcAnchorUs = 0;         // esp_timer time it was known (0 = never)
+static int64_t rtcAnchorOffsetUs = 0;
+static bool rtcAnchorMeasured = false;  // From an edge, not assumed after a write
+static bool rtcDriftSeeded = false;
+static bool rtcWritePending = false;
+static bool rtcVerifyPending = false;   // The next edge measures a write
+
+static SoftClockStats clockStats = {};
+
+static int64_t systemMicros() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**
+ * Part of the last adjtime() correction not slewed in yet
+ */
+static int64_t pendingSlewUs() {
+    struct timeval left;
+    if (adjtime(NULL, &left) != 0) return 0;
+    return (int64_t)left.tv_sec * 1000000 + left.tv_usec;
+}
+
+static void setSystemMicros(int64_t us) {
+    struct timeval tv = { (time_t)(us / 1000000), (suseconds_t)(us % 1000000) };
+    settimeofday(&tv, NULL);
+}
+
+static int32_t clampOffset(int64_t us) {
+    if (us > INT32_MAX) return INT32_MAX;
+    if (us < INT32_MIN) return INT32_MIN;
+    return (int32_t)us;
+}
+
+/**
+ * DS1302 local time to UTC epoch seconds (civil calendar, no TZ needed)
+ */
+static int64_t localToEpoch(const DateTime& dt) {
+    return civilToEpoch(dt.year, dt.month, dt.day,
+                        dt.hour, dt.minute, dt.second) - gmtOffset_sec;
+}
+
+static DateTime epochToLocal(int64_t epoch) {
+    time_t local = (time_t)(epoch + gmtOffset_sec);
+    struct tm tm;
+    gmtime_r(&local, &tm);
+    
+    return DateTime(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                    tm.tm_hour, tm.tm_min, tm.tm_sec);
+}
+
+static bool isPlausible(const DateTime& dt) {
+    return dt.year >= 2000 && dt.month >= 1 && dt.month <= 12 &&
+           dt.day >= 1 && dt.day <= 31 && dt.hour <= 23 &&
+           dt.minute <= 59 && dt.second <= 59;
+}
+
+static DateTime timedRead() {
+    int64_t start = esp_timer_get_time();
+    DateTime dt = rtc.getDateTime();
+    clockStats.lastReadUs = esp_timer_get_time() - start;
+    return dt;
+}
+
+static bool isNtpFresh() {
+    return clockStats.ntpSyncCount > 0 &&
+           millis() - clockStats.lastNtpMs < NTP_HOLDOVER_MS;
+}
+
+static float smoothPpm(float current, float sample, bool& seeded) {
+    float next = seeded ? current + (sample - current) / 4 : sample;
+    seeded = true;
+    return next;
+}
+
+/**
+ * Expected DS1302 error (DS1302 minus true time) at atUs, from the last
+ * measurement and the drift since
+ */
+static int64_t predictRtcError(int64_t atUs) {
+    if (!rtcAnchorUs) return 0;
+    return rtcAnchorOffsetUs +
+           (int64_t)(clockStats.driftPpm * (atUs - rtcAnchorUs) / 1e6f);
+}
+
+/**
+ * Schedule a DS1302 resync after delayMs
+ */
+static void scheduleResync(unsigned long delayMs) {
+    resyncStartedAt = millis() - RTC_RESYNC_INTERVAL_MS + delayMs;
+}
+
+/**
+ * Software clock time at an earlier esp_timer time
+ */
+static int64_t epochMicrosAt(int64_t atUs) {
+    return getEpochMicros() - (esp_timer_get_time() - atUs);
+}
+
 /**
- * Initialize and sync RTC with NTP server
+ * Correct the software clock toward the reference
+ * getEpochMicros() is the system clock plus the slew still running plus
+ * the drift predicted since the last correction. Both are folded into the
+ * new step/slew, so timestamps stay continuous across it; what is left
+ * over is the prediction's error and refines the drift.
+ * @param offsetUs - Reference minus getEpochMicros() at atUs
+ * @param atUs - esp_timer time of the measurement
+ * @return true if the clock was stepped rather than slewed
  */
-void setupAndSyncRTC() {
-    rtc.begin();
+static bool correctClock(int64_t offsetUs, int64_t atUs) {
+    int64_t absOffset = offsetUs < 0 ? -offsetUs : offsetUs;
+    bool step = absOffset >= RTC_STEP_THRESHOLD_US;
+    int64_t interval = atUs - lastCorrectionUs;
+    
+    if (lastCorrectionUs && !step && interval >= 60000000LL) {
+        clockStats.clockDriftPpm = smoothPpm(clockStats.clockDriftPpm,
+                                             predictPpm + offsetUs * 1e6f / interval,
+                                             clockDriftSeeded);
+    }
+    
+    portENTER_CRITICAL(&clockMux);
+    clockSeq++;
+    portEXIT_CRITICAL(&clockMux);
+    
+    int64_t nowUs = esp_timer_get_time();
+    int64_t correctionUs = offsetUs + pendingSlewUs() +
+                           (lastCorrectionUs ? (int64_t)((nowUs - lastCorrectionUs) * predictPpm / 1e6f) : 0);
+    
+    if (step) {
+        // settimeofday() also drops the slew in progress
+        setSystemMicros(systemMicros() + correctionUs);
+        clockStats.stepCount++;
+    } else {
+        struct timeval delta = { (time_t)(correctionUs / 1000000), (suseconds_t)(correctionUs % 1000000) };
+        adjtime(&delta, NULL);
+    }
     
-    // Configure NTP
-    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
+    portENTER_CRITICAL(&clockMux);
+    lastCorrectionUs = nowUs;
+    predictPpm = clockStats.clockDriftPpm;
+    clockSeq++;
+    portEXIT_CRITICAL(&clockMux);
     
-    struct tm timeinfo;
-    if (getLocalTime(&timeinfo, 10000)) { // wait max 10 sec
-        DateTime ntpTime(
-            timeinfo.tm_year + 1900,
-            timeinfo.tm_mon + 1,
-            timeinfo.tm_mday,
-            timeinfo.tm_hour,
-            timeinfo.tm_min,
-            timeinfo.tm_sec
-        );
+    return step;
+}
+
+/**
+ * Apply an NTP answer
+ * @param timeUs - UTC from the answer
+ * @param atUs - esp_timer time it arrived
+ */
+static void applyNtp(int64_t timeUs, int64_t atUs) {
+    int64_t offsetUs = timeUs - epochMicrosAt(atUs);
+    bool first = clockStats.ntpSyncCount == 0;
+    bool step = correctClock(offsetUs, atUs);
+    
+    ntpHistory[ntpHistoryHead].atUs = atUs;
+    ntpHistory[ntpHistoryHead].offsetUs = clampOffset(offsetUs);
+    ntpHistoryHead = (ntpHistoryHead + 1) % NTP_HISTORY_LEN;
+    if (ntpHistoryCount < NTP_HISTORY_LEN) ntpHistoryCount++;
+    
+    clockStats.ntpSyncCount++;
+    clockStats.lastNtpOffsetUs = clampOffset(offsetUs);
+    clockStats.lastNtpMs = millis();
+    
+    // First answer this boot or a jump: the DS1302 needs the new time
+    if (first || step) {
+        rtcWritePending = true;
+    }
+    
+    Serial.printf("🕐 NTP offset %.3f s%s, clock drift %.1f ppm\n",
+                  offsetUs / 1e6, step ? " (stepped)" : "", clockStats.clockDriftPpm);
+}
+
+/**
+ * Write the DS1302 from the clock at the start of a second
+ * A pass within RTC_WRITE_LEAD_US of the boundary waits for it, so a
+ * write lands within a few seconds and never blocks for long.
+ */
+static void writeRtcFromClock() {
+    int64_t now = getEpochMicros();
+    int64_t intoSecond = now % 1000000;
+    
+    if (intoSecond > RTC_WRITE_WINDOW_US) {
+        int64_t waitUs = 1000000 - intoSecond;
+        if (waitUs > RTC_WRITE_LEAD_US) return;
+        
+        delayMicroseconds((uint32_t)waitUs);
+        now = getEpochMicros();
+        if (now % 1000000 > RTC_WRITE_WINDOW_US) return;  // Preempted, next second
+    }
+    
+    DateTime dt = epochToLocal(now / 1000000);
+    rtc.setDateTime(dt);
+    
+    rtcWritePending = false;
+    rtcAnchorUs = esp_timer_get_time();
+    rtcAnchorOffsetUs = 0;
+    rtcAnchorMeasured = false;
+    rtcVerifyPending = true;
+    clockStats.rtcWrites++;
+    
+    Serial.printf("✅ RTC synced: %04u-%02u-%02u %02u:%02u:%02u\n",
+                  dt.year, dt.month, dt.day, dt.hour, dt.minute, dt.second);
+    
+    // Measure where the write actually landed
+    scheduleResync(RTC_VERIFY_DELAY_MS);
+}
+
+/**
+ * Compare the DS1302 with the system clock at a seconds edge
+ * @param edgeUs - esp_timer time of the edge
+ */
+static void applyEdge(int64_t edgeUs) {
+    DateTime dt = timedRead();
+    if (!isPlausible(dt)) return;
+    
+    int64_t offsetUs = localToEpoch(dt) * 1000000 - epochMicrosAt(edgeUs);
+    int64_t absOffset = offsetUs < 0 ? -offsetUs : offsetUs;
+    
+    clockStats.syncCount++;
+    clockStats.lastOffsetUs = clampOffset(offsetUs);
+    clockStats.lastSyncMs = millis();
+    if (absOffset > clockStats.maxOffsetUs) {
+        clockStats.maxOffsetUs = absOffset > UINT32_MAX ? UINT32_MAX : (uint32_t)absOffset;
+    }
+    
+    if (rtcVerifyPending) {
+        rtcVerifyPending = false;
+        clockStats.rtcWritesVerified++;
+        clockStats.lastWriteOffsetUs = clampOffset(offsetUs);
+        Serial.printf("🕐 RTC write landed %+.3f ms off\n", offsetUs / 1e3);
+    }
+    
+    if (isNtpFresh()) {
+        // The system clock is NTP-true: this is the DS1302's own error
+        int64_t interval = edgeUs - rtcAnchorUs;
+        if (rtcAnchorMeasured && interval >= 60000000LL) {
+            clockStats.driftPpm = smoothPpm(clockStats.driftPpm,
+                                            (offsetUs - rtcAnchorOffsetUs) * 1e6f / interval,
+                                            rtcDriftSeeded);
+            clockStats.driftSamples++;
+        }
         
-        rtc.setDateTime(ntpTime);
-        Serial.printf("✅ RTC synced: %04u-%02u-%02u %02u:%02u:%02u\n",
-                        ntpTime.year, ntpTime.month, ntpTime.day,
-                        ntpTime.hour, ntpTime.minute, ntpTime.second);
+        rtcAnchorUs = edgeUs;
+        rtcAnchorOffsetUs = offsetUs;
+        rtcAnchorMeasured = true;
+        
+        if (absOffset >= RTC_REWRITE_THRESHOLD_US) {
+            rtcWritePending = true;
+        }
+    } else {
+        // The DS1302 is the reference, minus the error it gathered since
+        // NTP last saw it
+        correctClock(offsetUs - predictRtcError(edgeUs), edgeUs);
+    }
+    
+    #if DEBUG_RTC
+    Serial.printf("🕐 DS1302 offset %.3f ms (%s), DS1302 drift %.1f ppm\n",
+                  offsetUs / 1e3, clockStats.ntpFresh ? "measured" : "applied",
+                  clockStats.driftPpm);
+    #endif
+}
+
+/**
+ * Spin on the DS1302 seconds register until it ticks over
+ * Blocks the caller for up to maxUs, so only called for a few ms around
+ * an edge that is already placed.
+ * @param maxUs - Give up after this long
+ * @param edgeUs - Set to the esp_timer time of the edge
+ * @return true if the edge was seen within RTC_EDGE_MAX_GAP_US
+ */
+static bool captureEdge(int64_t maxUs, int64_t& edgeUs) {
+    int64_t prevUs = esp_timer_get_time();
+    int64_t deadline = prevUs + maxUs;
+    uint8_t startSecond = rtc.getSeconds();
+    
+    while (prevUs < deadline) {
+        delayMicroseconds(RTC_EDGE_POLL_US);
+        int64_t pollUs = esp_timer_get_time();
+        if (rtc.getSeconds() != startSecond) {
+            // The edge lies between the two polls; a preempted poll blurs it
+            if (pollUs - prevUs > RTC_EDGE_MAX_GAP_US) return false;
+            
+            edgeUs = (prevUs + pollUs) / 2;
+            return true;
+        }
+        prevUs = pollUs;
+    }
+    return false;
+}
+
+/**
+ * esp_timer time of the next DS1302 edge predicted from the last
+ * measurement, at least RTC_EDGE_LEAD_US away
+ */
+static int64_t predictEdge() {
+    int64_t nowUs = esp_timer_get_time();
+    int64_t phase = (getEpochMicros() + predictRtcError(nowUs)) % 1000000;
+    if (phase < 0) phase += 1000000;
+    
+    int64_t waitUs = 1000000 - phase;
+    if (waitUs < RTC_EDGE_LEAD_US) waitUs += 1000000;
+    return nowUs + waitUs;
+}
+
+static void startPhaseSearch() {
+    resyncState = RESYNC_FIND_PHASE;
+    phaseStartedAt = millis();
+    phasePollUs = esp_timer_get_time();
+    phaseSecond = rtc.getSeconds();
+}
+
+/**
+ * One seconds-register read per loop pass: a tick seen between two
+ * passes places the edge to within a pass, and the edge a second later
+ * is then caught by a short spin
+ */
+static void findPhase() {
+    if (millis() - phaseStartedAt > RTC_EDGE_TIMEOUT_MS) {
+        // Halted or missing DS1302
+        clockStats.edgeTimeouts++;
+        resyncState = RESYNC_IDLE;
+        return;
+    }
+    
+    int64_t prevUs = phasePollUs;
+    phasePollUs = esp_timer_get_time();
+    uint8_t second = rtc.getSeconds();
+    if (second == phaseSecond) return;
+    phaseSecond = second;
+    
+    int64_t gapUs = phasePollUs - prevUs;
+    if (gapUs > RTC_EDGE_MAX_PASS_US) return;   // Stalled pass - wait for the next tick
+    
+    edgeDueUs = (prevUs + phasePollUs) / 2 + 1000000;
+    edgeLeadUs = gapUs / 2 + RTC_EDGE_MARGIN_US;
+    resyncState = RESYNC_WAIT_EDGE;
+}
+
+/**
+ * Spin until the end of the window around the placed edge and apply it
+ * A miss goes back to the per-pass search, up to RTC_EDGE_MAX_SPINS.
+ */
+static void catchEdge(int64_t nowUs) {
+    int64_t edgeUs = 0;
+    bool caught = captureEdge(edgeDueUs + edgeLeadUs - nowUs, edgeUs);
+    edgeAttempts++;
+    
+    edgePredictable = caught;
+    if (caught) {
+        resyncState = RESYNC_IDLE;
+        applyEdge(edgeUs);
+    } else if (edgeAttempts >= RTC_EDGE_MAX_SPINS) {
+        clockStats.edgeTimeouts++;
+        resyncState = RESYNC_IDLE;
+    } else {
+        startPhaseSearch();
+    }
+}
+
+/**
+ * SNTP answer hook (overrides the weak ESP-IDF default; runs on the
+ * lwIP task). The default steps the system clock right here - instead
+ * the answer goes to the main loop, which slews it in and records it.
+ */
+extern "C" void sntp_sync_time(struct timeval* tv) {
+    portENTER_CRITICAL(&ntpMux);
+    ntpTimeUs = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+    ntpAtUs = esp_timer_get_time();
+    ntpPending = true;
+    portEXIT_CRITICAL(&ntpMux);
+    
+    sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+}
+
+void initSoftClock() {
+    DateTime dt = timedRead();
+    
+    if (isPlausible(dt)) {
+        setSystemMicros(localToEpoch(dt) * 1000000);
     } else {
-        Serial.println("⚠️ Failed to get time from NTP");
+        Serial.println("⚠️ DS1302 time invalid, waiting for NTP");
+    }
+    
+    portENTER_CRITICAL(&clockMux);
+    lastCorrectionUs = esp_timer_get_time();
+    portEXIT_CRITICAL(&clockMux);
+    
+    // The boot read is only +/- 1 s; find the edge right away
+    scheduleResync(0);
+    resyncState = RESYNC_IDLE;
+}
+
+void startNtpSync() {
+    if (sntp_enabled()) return;
+    
+    sntp_set_sync_interval(NTP_SYNC_INTERVAL_MS);
+    
+    // The system clock is UTC; local time is applied in epochToLocal()
+    configTime(0, 0, ntpServer);
+    Serial.println("🕐 NTP sync running in background");
+}
+
+void softClockLoop() {
+    if (ntpPending) {
+        portENTER_CRITICAL(&ntpMux);
+        int64_t timeUs = ntpTimeUs;
+        int64_t atUs = ntpAtUs;
+        ntpPending = false;
+        portEXIT_CRITICAL(&ntpMux);
+        
+        applyNtp(timeUs, atUs);
+    }
+    clockStats.ntpFresh = isNtpFresh();
+    
+    if (rtcWritePending && clockStats.ntpFresh && resyncState == RESYNC_IDLE) {
+        writeRtcFromClock();
+    }
+    
+    unsigned long now = millis();
+    
+    switch (resyncState) {
+        case RESYNC_IDLE:
+            if (now - resyncStartedAt < RTC_RESYNC_INTERVAL_MS) return;
+            resyncStartedAt = now;
+            edgeAttempts = 0;
+            
+            // Unknown phase (boot, or the last spin missed): search for it
+            if (!edgePredictable) {
+                startPhaseSearch();
+                return;
+            }
+            edgeDueUs = predictEdge();
+            edgeLeadUs = RTC_EDGE_LEAD_US;
+            resyncState = RESYNC_WAIT_EDGE;
+            return;
+            
+        case RESYNC_FIND_PHASE:
+            findPhase();
+            return;
+            
+        case RESYNC_WAIT_EDGE: {
+            // Only block for the few ms around the edge
+            int64_t nowUs = esp_timer_get_time();
+            if (nowUs < edgeDueUs - edgeLeadUs) return;
+            if (nowUs > edgeDueUs) {
+                // Pass landed too late to see the edge - try the next one
+                if (++edgeAttempts >= RTC_EDGE_MAX_SPINS) {
+                    clockStats.edgeTimeouts++;
+                    edgePredictable = false;
+                    resyncState = RESYNC_IDLE;
+                    return;
+                }
+                edgeDueUs += 1000000;
+                return;
+            }
+            catchEdge(nowUs);
+            return;
+        }
+    }
+}
+
+int64_t getEpochMicros() {
+    for (;;) {
+        portENTER_CRITICAL(&clockMux);
+        uint32_t seq = clockSeq;
+        int64_t correctedAtUs = lastCorrectionUs;
+        float ppm = predictPpm;
+        portEXIT_CRITICAL(&clockMux);
+        
+        // A correction is moving the prediction into the slew - wait it out
+        // (sleep, so a caller on the main loop's core lets it finish)
+        if (seq & 1) {
+            vTaskDelay(1);
+            continue;
+        }
+        
+        int64_t now = systemMicros() + pendingSlewUs();
+        if (correctedAtUs && ppm != 0) {
+            now += (int64_t)((esp_timer_get_time() - correctedAtUs) * ppm / 1e6f);
+        }
+        if (clockSeq == seq) return now;
+    }
+}
+
+Timestamp getTimestamp() {
+    int64_t us = getEpochMicros();
+    if (us <= 0) return Timestamp();
+    
+    return Timestamp((uint32_t)(us / 1000000), (uint16_t)((us % 1000000) / 1000));
+}
+
+DateTime toDateTime(const Timestamp& ts) {
+    return epochToLocal(ts.epoch);
+}
+
+SoftClockStats getSoftClockStats() {
+    return clockStats;
+}
+
+uint8_t getNtpHistory(NtpSample* out, uint8_t maxSamples) {
+    uint8_t count = ntpHistoryCount < maxSamples ? ntpHistoryCount : maxSamples;
+    uint8_t first = (ntpHistoryHead + NTP_HISTORY_LEN - count) % NTP_HISTORY_LEN;
+    
+    for (uint8_t i = 0; i < count; i++) {
+        out[i] = ntpHistory[(first + i) % NTP_HISTORY_LEN];
     }
+    return count;
 }
 
+// =============================================================================
+// NTP SYNC AND UTILITY FUNCTIONS
+// =============================================================================
+
 /**
  * Print DateTime in human-readable format
  */
@@ -319,8 +928,8 @@ void printDateTime(const DateTime& dt) {
 }
 
 /**
- * Get current time from RTC
+ * Get current local time from the software clock
  */
 DateTime getCurrentTime() {
-    return rtc.getDateTime();
+    return epochToLocal(getEpochMicros() / 1000000);
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "UserDatabase.h"
 #include <ArduinoJson.h>
 #include <map>
+#include <set>
 
 // =============================================================================
 // EXTERNAL REFERENCES
@@ -19,13 +20,24 @@ extern bool firebaseInitialized;
 // FIREBASE OBJECTS
 // =============================================================================
 
+#ifdef TAPTRACK_BENCH
+// Bench build talks to tools/rtdb_standin, which has no auth endpoint
+static NoAuth no_auth;
+#endif
+
 UserAuth user_auth(FIREBASE_API_KEY, FIREBASE_USER_EMAIL, FIREBASE_USER_PASSWORD);
 FirebaseApp app;
-WiFiClientSecure ssl_client;
 DefaultNetwork network;
-AsyncClientClass aClient(ssl_client, getNetwork(network));
 RealtimeDatabase Database;
 
+// Separate SSL contexts and task queues so a stalled stream never
+// holds up an attendance push (and vice versa)
+WiFiClientSecure stream_ssl_client;
+AsyncClientClass streamClient(stream_ssl_client, getNetwork(network));
+
+WiFiClientSecure write_ssl_client;
+AsyncClientClass writeClient(write_ssl_client, getNetwork(network));
+
 // JSON tools
 static object_t jsonData, obj1, obj2, obj3, obj4, obj5;
 static JsonWriter writer;
@@ -40,19 +52,221 @@ SyncState syncState = {
     .lastSyncTime = 0,
     .pendingCount = 0,
     .successCount = 0,
-    .failCount = 0
+    .failCount = 0,
+    .lastConfirmMs = 0,
+    .maxConfirmMs = 0,
+    .totalConfirmMs = 0
 };
 
-// Track pending operations by their task ID
-static std::map<String, bool> pendingOperations;
+// Track pending operations by their task ID (value = millis() when sent)
+static std::map<String, unsigned long> pendingOperations;
 static std::map<String, bool> confirmedOperations;
 
 // User change callback
 static UserChangeCallback userChangeCallback = nullptr;
 
+// Unregistered cards seen recently (coalesces /pendingUsers writes)
+struct PendingUserEntry {
+    CardUid uid;
+    Timestamp firstScannedAt;
+    Timestamp lastScannedAt;
+    unsigned long lastTapAt;    // LRU eviction
+    unsigned long lastSentAt;   // 0 = never written
+    unsigned long lastFetchAt;  // Last Get_User_ request
+    bool isNew;                 // firstScannedAt/status not yet written
+    bool dirty;                 // lastScannedAt changed since last write
+    uint16_t batch;             // Unconfirmed Update_Pending_<batch> carrying it (0 = none)
+    bool batchNew;              // That write carries the firstScannedAt/status fields
+    bool used;
+};
+
+static PendingUserEntry pendingUsers[PENDING_USER_TABLE_SIZE];
+static uint16_t pendingBatch = 0;
+
 // Stream state
 static bool userStreamActive = false;
+static bool userStreamWanted = false;       // Supervisor keeps it alive
+static bool streamSnapshotPending = false;  // Waiting for first "put /"
 static unsigned long lastStreamActivity = 0;
+static unsigned long streamSubscribedAt = 0;
+static unsigned long nextStreamAttempt = 0;
+static StreamHealth streamHealth = {};
+
+// =============================================================================
+// PENDING USER TABLE
+// =============================================================================
+
+static PendingUserEntry* findPendingUser(const CardUid& uid) {
+    for (auto& entry : pendingUsers) {
+        if (entry.used && entry.uid == uid) return &entry;
+    }
+    return nullptr;
+}
+
+/**
+ * Get a free slot, evicting the least recently tapped entry if full
+ * (clean entries go first so queued lastScannedAt updates survive)
+ */
+static PendingUserEntry* allocPendingUser() {
+    PendingUserEntry* victim = nullptr;
+    
+    for (auto& entry : pendingUsers) {
+        if (!entry.used) return &entry;
+        if (!victim ||
+            (victim->dirty && !entry.dirty) ||
+            (victim->dirty == entry.dirty && entry.lastTapAt < victim->lastTapAt)) {
+            victim = &entry;
+        }
+    }
+    
+    victim->used = false;
+    return victim;
+}
+
+/**
+ * Settle a /pendingUsers write; a failed one is resent after the window
+ * with everything it carried, so a first write is never lost
+ */
+static void settlePendingBatch(uint16_t batch, bool ok) {
+    for (auto& entry : pendingUsers) {
+        if (!entry.used || entry.batch != batch) continue;
+        
+        if (!ok) {
+            entry.dirty = true;
+            entry.isNew |= entry.batchNew;
+        }
+        entry.batch = 0;
+        entry.batchNew = false;
+    }
+}
+
+static void forgetPendingUser(const String& uidHex) {
+    CardUid uid;
+    if (!CardUid::fromHex(uidHex, uid)) return;
+    
+    PendingUserEntry* entry = findPendingUser(uid);
+    if (entry) entry->used = false;
+}
+
+// =============================================================================
+// STREAM HELPERS
+// =============================================================================
+
+/**
+ * Mark the stream dead and schedule the next resubscribe with backoff
+ */
+static void scheduleStreamRetry() {
+    streamClient.stopAsync();
+    userStreamActive = false;
+    streamSnapshotPending = false;
+    
+    int shift = min(streamHealth.retryCount, 5);
+    unsigned long backoff = min((unsigned long)STREAM_RECONNECT_MS << shift,
+                                (unsigned long)STREAM_RECONNECT_MAX_MS);
+    streamHealth.retryCount++;
+    nextStreamAttempt = millis() + backoff;
+    
+    Serial.printf("🔁 Stream resubscribe in %lu ms (attempt %d)\n",
+                  backoff, streamHealth.retryCount);
+}
+
+/**
+ * Open the /users SSE stream on the dedicated stream client
+ */
+static void subscribeUserStream() {
+    Database.get(streamClient, "/users", processData, true, "UserStream");
+    
+    userStreamActive = true;
+    streamSnapshotPending = true;
+    streamSubscribedAt = millis();
+    lastStreamActivity = streamSubscribedAt;
+    streamHealth.resubscribeCount++;
+}
+
+/**
+ * Add, rename or remove one user from a stream event
+ * @return true if the local database changed
+ */
+static bool applyUserChange(String uid, JsonVariant data) {
+    uid.toUpperCase();
+    
+    if (data.isNull()) {
+        if (!userDB.isRegistered(uid)) return false;
+        
+        Serial.printf("📤 Stream: user removed %s\n", uid.c_str());
+        userDB.unregisterUser(uid);
+        if (userChangeCallback) {
+            userChangeCallback(uid, "", false);
+        }
+        return true;
+    }
+    
+    JsonObject userObj = data.as<JsonObject>();
+    String name = "";
+    
+    if (!userObj.isNull()) {
+        if (userObj.containsKey("uid")) {
+            uid = userObj["uid"].as<String>();
+            uid.toUpperCase();
+        }
+        if (userObj.containsKey("name")) {
+            name = userObj["name"].as<String>();
+        }
+    }
+    
+    // Unchanged users are skipped so a resubscribe snapshot is silent
+    if (name.length() == 0 || (userDB.isRegistered(uid) && userDB.getName(uid) == name)) {
+        return false;
+    }
+    
+    userDB.registerUser(uid, name);
+    forgetPendingUser(uid);
+    Serial.printf("📥 Stream: registered %s (%s)\n", name.c_str(), uid.c_str());
+    
+    if (userChangeCallback) {
+        userChangeCallback(uid, name, true);
+    }
+    return true;
+}
+
+/**
+ * Reconcile the local roster against a full /users snapshot.
+ * Users missing from the snapshot were deleted while we were not
+ * listening and are dropped locally.
+ */
+static void applyUserSnapshot(JsonVariant data) {
+    std::set<String> seen;
+    bool changed = false;
+    
+    if (data.is<JsonObject>()) {
+        for (JsonPair kv : data.as<JsonObject>()) {
+            String uid = String(kv.key().c_str());
+            uid.toUpperCase();
+            
+            JsonObject userObj = kv.value().as<JsonObject>();
+            if (!userObj.isNull() && userObj.containsKey("uid")) {
+                String innerUid = userObj["uid"].as<String>();
+                innerUid.toUpperCase();
+                seen.insert(innerUid);
+            }
+            seen.insert(uid);
+            
+            changed |= applyUserChange(uid, kv.value());
+        }
+    }
+    
+    for (const String& uid : userDB.getAllUIDs()) {
+        if (!seen.count(uid)) {
+            changed |= applyUserChange(uid, JsonVariant());
+        }
+    }
+    
+    if (changed) {
+        userDB.saveToSPIFFS();
+    }
+    Serial.printf("📥 Stream snapshot: %d users%s\n", (int)seen.size(),
+                  changed ? " (roster updated)" : "");
+}
 
 // =============================================================================
 // INITIALIZATION
@@ -61,13 +275,24 @@ static unsigned long lastStreamActivity = 0;
 void initFirebase() {
     Serial.println(F("🔥 Initializing Firebase..."));
     
-    ssl_client.setInsecure();
-    ssl_client.setTimeout(1000);
-    ssl_client.setHandshakeTimeout(5);
+    write_ssl_client.setInsecure();
+    write_ssl_client.setTimeout(1000);
+    write_ssl_client.setHandshakeTimeout(5);
+    
+    stream_ssl_client.setInsecure();
+    stream_ssl_client.setTimeout(1000);
+    stream_ssl_client.setHandshakeTimeout(5);
     
-    initializeApp(aClient, app, getAuth(user_auth), processData, "authTask");
+#ifdef TAPTRACK_BENCH
+    initializeApp(writeClient, app, getAuth(no_auth), processData, "authTask");
+    app.getApp<RealtimeDatabase>(Database);
+    Database.url(BENCH_DATABASE_URL);
+    Serial.printf("🧪 Bench build: using stand-in %s\n", BENCH_DATABASE_URL);
+#else
+    initializeApp(writeClient, app, getAuth(user_auth), processData, "authTask");
     app.getApp<RealtimeDatabase>(Database);
     Database.url(FIREBASE_DATABASE_URL);
+#endif
     
     syncState.status = SYNC_IDLE;
     Serial.println(F("✓ Firebase initialized"));
@@ -118,6 +343,21 @@ void processData(AsyncResult &aResult) {
             syncState.status = SYNC_FAILED;
         }
         
+        // Stream dropped - let the supervisor resubscribe
+        if (tag.startsWith("UserStream") && userStreamActive) {
+            scheduleStreamRetry();
+        }
+        
+        if (tag.startsWith("Update_Pending_")) {
+            settlePendingBatch(tag.substring(15).toInt(), false);
+        }
+        
+        // Create-only rollup refused: the day was already recorded
+        if (tag.startsWith("Set_DayRollup_") &&
+            aResult.error().message().indexOf("Permission denied") >= 0) {
+            confirmedOperations[tag] = true;
+        }
+        
         return;
     }
     
@@ -134,7 +374,15 @@ void processData(AsyncResult &aResult) {
         // =========================================
         if (tag.startsWith("Push_Attendance_")) {
             confirmedOperations[tag] = true;
-            pendingOperations.erase(tag);
+            if (pendingOperations.count(tag)) {
+                unsigned long latency = millis() - pendingOperations[tag];
+                syncState.lastConfirmMs = latency;
+                syncState.totalConfirmMs += latency;
+                if (latency > syncState.maxConfirmMs) {
+                    syncState.maxConfirmMs = latency;
+                }
+                pendingOperations.erase(tag);
+            }
             syncState.successCount++;
             syncState.lastSyncTime = millis();
             syncState.status = SYNC_SUCCESS;
@@ -221,6 +469,7 @@ void processData(AsyncResult &aResult) {
             if (name.length() > 0) {
                 userDB.registerUser(uid, name);
                 userDB.saveToSPIFFS();
+                forgetPendingUser(uid);
                 Serial.printf("✅ Registered user from Firebase: %s (%s)\n", 
                              name.c_str(), uid.c_str());
                 
@@ -236,7 +485,15 @@ void processData(AsyncResult &aResult) {
         // =========================================
         if (tag.startsWith("UserStream") || tag.startsWith("task_")) {
             lastStreamActivity = millis();
-            userStreamActive = true;
+            
+            RealtimeDatabaseResult &stream = aResult.to<RealtimeDatabaseResult>();
+            String event = stream.event();
+            
+            if (event == "cancel" || event == "auth_revoked") {
+                Serial.printf("⚠️ Stream %s, resubscribing\n", event.c_str());
+                scheduleStreamRetry();
+                return;
+            }
             
             // Find JSON in stream payload
             const char* jsonStart = strchr(payload, '{');
@@ -258,76 +515,35 @@ void processData(AsyncResult &aResult) {
                 String path = root["path"].as<String>();
                 JsonVariant data = root["data"];
                 
-                if (path == "/") {
-                    // Full payload - iterate all users
+                if (path == "/" && event != "patch") {
+                    // Full snapshot - first event after every (re)subscribe
+                    applyUserSnapshot(data);
+                    
+                    if (streamSnapshotPending) {
+                        streamSnapshotPending = false;
+                        streamHealth.lastCatchupMs = millis() - streamSubscribedAt;
+                        streamHealth.retryCount = 0;
+                        Serial.printf("✓ Stream caught up in %lu ms\n", streamHealth.lastCatchupMs);
+                    }
+                } else if (path == "/") {
+                    // Multi-user patch - only the listed children changed
+                    bool changed = false;
                     if (data.is<JsonObject>()) {
                         for (JsonPair kv : data.as<JsonObject>()) {
-                            String uid = String(kv.key().c_str());
-                            uid.toUpperCase();
-                            String name = "";
-                            
-                            JsonObject userObj = kv.value().as<JsonObject>();
-                            if (!userObj.isNull()) {
-                                if (userObj.containsKey("uid")) {
-                                    uid = userObj["uid"].as<String>();
-                                    uid.toUpperCase();
-                                }
-                                if (userObj.containsKey("name")) {
-                                    name = userObj["name"].as<String>();
-                                }
-                            }
-                            
-                            if (name.length() > 0) {
-                                userDB.registerUser(uid, name);
-                                Serial.printf("📥 Stream: user %s (%s)\n", 
-                                             name.c_str(), uid.c_str());
-                                
-                                if (userChangeCallback) {
-                                    userChangeCallback(uid, name, true);
-                                }
-                            }
+                            changed |= applyUserChange(String(kv.key().c_str()), kv.value());
                         }
-                        userDB.saveToSPIFFS();
                     }
+                    if (changed) userDB.saveToSPIFFS();
                 } else {
-                    // Single user change - path like "/2048C51A"
+                    // Single user change - path like "/2048C51A" or "/2048C51A/name"
                     String uid = path.substring(1);
-                    uid.toUpperCase();
+                    int slash = uid.indexOf('/');
                     
-                    if (data.isNull()) {
-                        // User deleted
-                        Serial.printf("📤 Stream: user removed %s\n", uid.c_str());
-                        userDB.unregisterUser(uid);
+                    if (slash >= 0) {
+                        // Field-level change, re-read the whole user
+                        fetchUserFromFirebase(uid.substring(0, slash));
+                    } else if (applyUserChange(uid, data)) {
                         userDB.saveToSPIFFS();
-                        
-                        if (userChangeCallback) {
-                            userChangeCallback(uid, "", false);
-                        }
-                    } else {
-                        // User added/modified
-                        JsonObject userObj = data.as<JsonObject>();
-                        String name = "";
-                        
-                        if (!userObj.isNull()) {
-                            if (userObj.containsKey("uid")) {
-                                uid = userObj["uid"].as<String>();
-                                uid.toUpperCase();
-                            }
-                            if (userObj.containsKey("name")) {
-                                name = userObj["name"].as<String>();
-                            }
-                        }
-                        
-                        if (name.length() > 0) {
-                            userDB.registerUser(uid, name);
-                            userDB.saveToSPIFFS();
-                            Serial.printf("📥 Stream: registered %s (%s)\n", 
-                                         name.c_str(), uid.c_str());
-                            
-                            if (userChangeCallback) {
-                                userChangeCallback(uid, name, true);
-                            }
-                        }
                     }
                 }
             }
@@ -337,7 +553,15 @@ void processData(AsyncResult &aResult) {
         // =========================================
         // Handle other confirmations
         // =========================================
-        if (tag.startsWith("Set_Pending") || tag.startsWith("Set_User")) {
+        if (tag.startsWith("Update_Pending_")) {
+            settlePendingBatch(tag.substring(15).toInt(), true);
+        }
+        if (tag.startsWith("Set_DayRollup_")) {
+            confirmedOperations[tag] = true;
+            pendingOperations.erase(tag);
+        }
+        if (tag.startsWith("Update_Pending") || tag.startsWith("Set_User") ||
+            tag.startsWith("Set_DayRollup")) {
             Serial.printf("✅ Operation confirmed: %s\n", tag.c_str());
             return;
         }
@@ -348,7 +572,41 @@ void processData(AsyncResult &aResult) {
 // ATTENDANCE FUNCTIONS
 // =============================================================================
 
-String sendToFirebase(String uid, String name, String timestamp,
+#if ATTENDANCE_DAY_ROLLUP
+String sendDayRollup(const CardUid& cardUid, const Timestamp& time, String attendanceStatus) {
+    if (!app.ready()) return "";
+    
+    char uid[CARD_UID_HEX_LEN];
+    cardUid.toHex(uid);
+    
+    // Local calendar day
+    char date[TIMESTAMP_DATE_LEN];
+    time.toLocalDate(date);
+    String path = "/attendanceByDay/" + String(date) + "/" + String(uid);
+    
+#if ATTENDANCE_SCHEMA_VERSION >= 2
+    StaticJsonDocument<64> doc;
+    doc["t"] = time.epoch;
+    doc["a"] = attendanceStatus == "late" ? ATTENDANCE_CODE_LATE : ATTENDANCE_CODE_PRESENT;
+#else
+    char iso[TIMESTAMP_ISO_LEN];
+    time.toIso(iso);
+    StaticJsonDocument<128> doc;
+    doc["timestamp"] = iso;
+    doc["attendanceStatus"] = attendanceStatus;
+#endif
+    String payload;
+    serializeJson(doc, payload);
+    
+    String syncId = "Set_DayRollup_" + String(millis());
+    pendingOperations[syncId] = millis();
+    Database.set<object_t>(writeClient, path.c_str(), object_t(payload), processData, syncId.c_str());
+    
+    return syncId;
+}
+#endif
+
+String sendToFirebase(const CardUid& cardUid, String name, const Timestamp& time,
                       String attendanceStatus, String registrationStatus) {
     
     if (!app.ready()) {
@@ -356,24 +614,44 @@ String sendToFirebase(String uid, String name, String timestamp,
         return "";
     }
     
+    // Hex only at the wire edge
+    char uid[CARD_UID_HEX_LEN];
+    cardUid.toHex(uid);
+    
     // Generate unique sync ID
     String syncId = "Push_Attendance_" + String(millis());
     
     // Build JSON
-    writer.create(obj1, "uid", uid);
+#if ATTENDANCE_SCHEMA_VERSION >= 2
+    // Compact record - short keys, epoch seconds, enum codes, no name
+    StaticJsonDocument<128> doc;
+    doc["v"] = ATTENDANCE_SCHEMA_VERSION;
+    doc["u"] = uid;
+    doc["t"] = time.epoch;
+    doc["a"] = attendanceStatus == "late" ? ATTENDANCE_CODE_LATE : ATTENDANCE_CODE_PRESENT;
+    doc["r"] = registrationStatus == "registered" ? REGISTRATION_CODE_REGISTERED
+                                                  : REGISTRATION_CODE_UNREGISTERED;
+    String payload;
+    serializeJson(doc, payload);
+    jsonData = object_t(payload);
+#else
+    writer.create(obj1, "uid", String(uid));
     writer.create(obj2, "name", name);
-    writer.create(obj3, "timestamp", timestamp);
+    char iso[TIMESTAMP_ISO_LEN];
+    time.toIso(iso);
+    writer.create(obj3, "timestamp", String(iso));
     writer.create(obj4, "attendanceStatus", attendanceStatus);
     writer.create(obj5, "registrationStatus", registrationStatus);
     writer.join(jsonData, 5, obj1, obj2, obj3, obj4, obj5);
+#endif
     
     // Track pending operation
-    pendingOperations[syncId] = true;
+    pendingOperations[syncId] = millis();
     syncState.pendingCount++;
     syncState.status = SYNC_IN_PROGRESS;
     
     // Push to Firebase
-    Database.push<object_t>(aClient, "/attendance", jsonData, processData, syncId.c_str());
+    Database.push<object_t>(writeClient, "/attendance", jsonData, processData, syncId.c_str());
     
     Serial.print(F("📤 Sending attendance: "));
     Serial.println(syncId);
@@ -389,6 +667,10 @@ bool isSyncConfirmed(String syncId) {
     return false;
 }
 
+bool isUploadInFlight() {
+    return !pendingOperations.empty();
+}
+
 String getLastSyncError() {
     return syncState.lastError;
 }
@@ -397,23 +679,87 @@ String getLastSyncError() {
 // USER MANAGEMENT
 // =============================================================================
 
-void sendPendingUser(String uid, String timestamp) {
-    if (!app.ready()) {
-        app.loop();
-        delay(100);
-        if (!app.ready()) return;
+void reportPendingUser(const CardUid& uid, const Timestamp& time) {
+    unsigned long now = millis();
+    
+    PendingUserEntry* entry = findPendingUser(uid);
+    if (!entry) {
+        entry = allocPendingUser();
+        entry->used = true;
+        entry->uid = uid;
+        entry->firstScannedAt = time;
+        entry->lastSentAt = 0;
+        entry->lastFetchAt = 0;
+        entry->isNew = true;
+        entry->batch = 0;
+        entry->batchNew = false;
     }
     
-    writer.create(obj1, "uid", uid);
-    writer.create(obj2, "status", "pending");
-    writer.create(obj3, "firstScannedAt", timestamp);
-    writer.create(obj4, "lastScannedAt", timestamp);
-    writer.join(jsonData, 4, obj1, obj2, obj3, obj4);
+    entry->lastScannedAt = time;
+    entry->lastTapAt = now;
+    entry->dirty = true;
     
-    String path = "/pendingUsers/" + uid;
-    Database.set<object_t>(aClient, path.c_str(), jsonData, processData, "Set_Pending");
+    // Only ask /users once per window in case the card was just registered
+    if (app.ready() && (entry->lastFetchAt == 0 || now - entry->lastFetchAt >= PENDING_USER_WINDOW_MS)) {
+        entry->lastFetchAt = now;
+        fetchUserFromFirebase(uid.toString());
+    }
     
-    Serial.printf("📤 Pending user sent: %s\n", uid.c_str());
+    if (entry->lastSentAt == 0) {
+        flushPendingUsers();
+    } else {
+        Serial.printf("📝 Pending user %s coalesced (next write in %lu s)\n", uid.toString().c_str(),
+                      (PENDING_USER_WINDOW_MS - min(now - entry->lastSentAt,
+                                                    (unsigned long)PENDING_USER_WINDOW_MS)) / 1000);
+    }
+}
+
+void flushPendingUsers() {
+    if (!app.ready()) return;
+    
+    unsigned long now = millis();
+    DynamicJsonDocument doc(JSON_BUFFER_SMALL);
+    int count = 0;
+    uint16_t batch = pendingBatch + 1;
+    if (batch == 0) batch = 1;
+    
+    for (auto& entry : pendingUsers) {
+        if (!entry.used || !entry.dirty) continue;
+        if (entry.lastSentAt != 0 && now - entry.lastSentAt < PENDING_USER_WINDOW_MS) continue;
+        
+        String uid = entry.uid.toString();
+        char iso[TIMESTAMP_ISO_LEN];
+        
+        // Multi-path keys keep sibling fields (e.g. admin notes) intact;
+        // an unconfirmed first write is carried again
+        bool sendNew = entry.isNew || entry.batchNew;
+        if (sendNew) {
+            doc[uid + "/uid"] = uid;
+            doc[uid + "/status"] = "pending";
+            entry.firstScannedAt.toIso(iso);
+            doc[uid + "/firstScannedAt"] = String(iso);
+        }
+        entry.lastScannedAt.toIso(iso);
+        doc[uid + "/lastScannedAt"] = String(iso);
+        
+        // Cleared now so taps during the write re-dirty it; restored on failure
+        entry.batchNew = sendNew;
+        entry.batch = batch;
+        entry.isNew = false;
+        entry.dirty = false;
+        entry.lastSentAt = now;
+        count++;
+    }
+    
+    if (count == 0) return;
+    pendingBatch = batch;
+    
+    String payload;
+    serializeJson(doc, payload);
+    String tag = "Update_Pending_" + String(batch);
+    Database.update<object_t>(writeClient, "/pendingUsers", object_t(payload), processData, tag.c_str());
+    
+    Serial.printf("📤 Pending users sent: %d\n", count);
 }
 
 void sendRegisteredUser(String uid, String name, String timestamp) {
@@ -426,7 +772,7 @@ void sendRegisteredUser(String uid, String name, String timestamp) {
     writer.join(jsonData, 4, obj1, obj2, obj3, obj4);
     
     String path = "/users/" + uid;
-    Database.set<object_t>(aClient, path.c_str(), jsonData, processData, "Set_User");
+    Database.set<object_t>(writeClient, path.c_str(), jsonData, processData, "Set_User");
     
     Serial.printf("📤 User registered: %s (%s)\n", name.c_str(), uid.c_str());
 }
@@ -444,7 +790,7 @@ void fetchAllUsersFromFirebase() {
         return;
     }
     
-    Database.get(aClient, "/users", processData, "Get_Users");
+    Database.get(writeClient, "/users", processData, "Get_Users");
     Serial.println(F("📥 Requested users from Firebase"));
 }
 
@@ -455,7 +801,7 @@ void fetchUserFromFirebase(String uid) {
     String path = "/users/" + uid;
     String tag = "Get_User_" + uid;
     
-    Database.get(aClient, path.c_str(), processData, tag.c_str());
+    Database.get(writeClient, path.c_str(), processData, tag.c_str());
     Serial.printf("📥 Requested user: %s\n", uid.c_str());
 }
 
@@ -467,32 +813,76 @@ void streamUsers() {
         attempts++;
     }
     
+    userStreamWanted = true;
+    
     if (!app.ready()) {
         Serial.println(F("⚠️ Firebase not ready for streaming"));
         return;
     }
     
-    Database.get(aClient, "/users", processData, true, "UserStream");
-    userStreamActive = true;
-    lastStreamActivity = millis();
+    streamHealth.retryCount = 0;
+    subscribeUserStream();
     Serial.println(F("✓ Streaming /users for realtime updates"));
 }
 
 void stopUserStream() {
-    // Note: FirebaseClient doesn't have explicit stream stop
-    // The stream will timeout naturally
+    // Only the stream runs on streamClient, so stopping its queue
+    // tears down the SSE connection without touching pending writes
+    streamClient.stopAsync();
     userStreamActive = false;
+    userStreamWanted = false;
+    streamSnapshotPending = false;
     Serial.println(F("🛑 User stream stopped"));
 }
 
 bool isUserStreamActive() {
-    // Consider stream inactive if no activity for 60 seconds
-    if (userStreamActive && (millis() - lastStreamActivity > 60000)) {
+    // Consider stream inactive if nothing (not even keep-alive) arrived
+    if (userStreamActive && (millis() - lastStreamActivity > STREAM_STALL_TIMEOUT_MS)) {
         userStreamActive = false;
     }
     return userStreamActive;
 }
 
+void maintainUserStream() {
+    if (!userStreamWanted || !app.ready()) return;
+    
+    unsigned long now = millis();
+    
+    if (userStreamActive) {
+        // RTDB sends keep-alive every ~30 s, so silence means the socket is dead
+        unsigned long limit = streamSnapshotPending ? STREAM_CONNECT_TIMEOUT_MS
+                                                    : STREAM_STALL_TIMEOUT_MS;
+        if (now - lastStreamActivity < limit) return;
+        
+        Serial.printf("⚠️ User stream stalled (%lu s silent)\n",
+                      (now - lastStreamActivity) / 1000);
+        streamHealth.stallCount++;
+        scheduleStreamRetry();
+        return;
+    }
+    
+    if ((long)(now - nextStreamAttempt) < 0) return;
+    
+    Serial.println(F("🔁 Resubscribing to /users stream"));
+    subscribeUserStream();
+}
+
+void restartUserStream() {
+    if (!userStreamWanted) return;
+    
+    streamClient.stopAsync();
+    userStreamActive = false;
+    streamSnapshotPending = false;
+    streamHealth.retryCount = 0;
+    nextStreamAttempt = millis();
+}
+
+StreamHealth getStreamHealth() {
+    streamHealth.active = isUserStreamActive();
+    streamHealth.lastActivity = lastStreamActivity;
+    return streamHealth;
+}
+
 // =============================================================================
 // SYNC STATE
 // =============================================================================
@@ -505,6 +895,9 @@ void resetSyncCounters() {
     syncState.successCount = 0;
     syncState.failCount = 0;
     syncState.pendingCount = 0;
+    syncState.lastConfirmMs = 0;
+    syncState.maxConfirmMs = 0;
+    syncState.totalConfirmMs = 0;
     confirmedOperations.clear();
     pendingOperations.clear();
 }
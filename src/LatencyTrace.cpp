@@ -0,0 +1,208 @@
+/*
+ * TapTrack - Latency Trace Implementation
+ * SPSC ring of finished traces + log-linear histograms
+ */
+
+#include "LatencyTrace.h"
+#include <atomic>
+#include <esp_timer.h>
+
+// =============================================================================
+// HISTOGRAM LAYOUT
+// =============================================================================
+
+// Log-linear buckets: exact below 4 us, then 4 buckets per power of two
+// (~12% resolution), capped at 2^24 us (~16 s)
+#define LATENCY_BUCKET_MAX_BIT  23
+#define LATENCY_BUCKET_COUNT    (4 * LATENCY_BUCKET_MAX_BIT)
+
+// Histogram rows: one per stage interval, then end to end
+#define LATENCY_ROW_TOTAL       (TRACE_POINT_COUNT - 1)
+#define LATENCY_ROW_COUNT       TRACE_POINT_COUNT
+#define LATENCY_NO_SAMPLE       0xFFFFFFFF
+
+static_assert((LATENCY_RING_SIZE & (LATENCY_RING_SIZE - 1)) == 0,
+              "LATENCY_RING_SIZE must be a power of 2");
+
+typedef struct {
+    uint32_t us[LATENCY_ROW_COUNT];     // LATENCY_NO_SAMPLE if a point was skipped
+} LatencySample;
+
+typedef struct {
+    uint32_t buckets[LATENCY_BUCKET_COUNT];
+    uint32_t count;
+    uint32_t maxUs;
+} LatencyHistogram;
+
+static const char* rowNames[LATENCY_ROW_COUNT] = {
+    "IRQ -> UID read",
+    "UID -> DB lookup",
+    "DB -> decision",
+    "Decision -> feedback",
+    "Total (IRQ -> feedback)"
+};
+
+// =============================================================================
+// STATE
+// =============================================================================
+
+// Open trace (tap path only)
+static int64_t openStamps[TRACE_POINT_COUNT];
+static bool traceOpen = false;
+
+// Finished traces: tap path produces, main loop consumes
+static LatencySample ring[LATENCY_RING_SIZE];
+static std::atomic<uint32_t> ringHead(0);
+static std::atomic<uint32_t> ringTail(0);
+static std::atomic<uint32_t> droppedTraces(0);
+
+// Consumer side
+static LatencyHistogram histograms[LATENCY_ROW_COUNT];
+
+// =============================================================================
+// HISTOGRAM HELPERS
+// =============================================================================
+
+static uint8_t bucketIndex(uint32_t us) {
+    if (us < 4) return us;
+
+    uint8_t msb = 31 - __builtin_clz(us);
+    if (msb > LATENCY_BUCKET_MAX_BIT) return LATENCY_BUCKET_COUNT - 1;
+
+    uint8_t sub = (us >> (msb - 2)) & 0x03;
+    return 4 * (msb - 1) + sub;
+}
+
+/**
+ * Midpoint of a bucket in microseconds
+ */
+static uint32_t bucketValue(uint8_t index) {
+    if (index < 4) return index;
+
+    uint8_t msb = index / 4 + 1;
+    uint32_t low = (uint32_t)(4 + index % 4) << (msb - 2);
+    uint32_t width = 1UL << (msb - 2);
+    return low + width / 2;
+}
+
+static uint32_t percentile(const LatencyHistogram& hist, uint8_t pct) {
+    if (hist.count == 0) return 0;
+
+    uint32_t target = (hist.count * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        seen += hist.buckets[i];
+        if (seen >= target) {
+            return min(bucketValue(i), hist.maxUs);
+        }
+    }
+    return hist.maxUs;
+}
+
+// =============================================================================
+// PRODUCER (TAP PATH)
+// =============================================================================
+
+static void pushTrace() {
+    LatencySample sample;
+
+    for (uint8_t i = 0; i < LATENCY_ROW_TOTAL; i++) {
+        sample.us[i] = (openStamps[i] && openStamps[i + 1])
+                           ? (uint32_t)(openStamps[i + 1] - openStamps[i])
+                           : LATENCY_NO_SAMPLE;
+    }
+    sample.us[LATENCY_ROW_TOTAL] =
+        (uint32_t)(openStamps[TRACE_INDICATOR] - openStamps[TRACE_ISR]);
+
+    uint32_t head = ringHead.load(std::memory_order_relaxed);
+    if (head - ringTail.load(std::memory_order_acquire) >= LATENCY_RING_SIZE) {
+        droppedTraces.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring[head & (LATENCY_RING_SIZE - 1)] = sample;
+    ringHead.store(head + 1, std::memory_order_release);
+}
+
+void latencyTraceBegin(int64_t irqUs, int64_t uidReadUs) {
+#if LATENCY_TRACE
+    memset(openStamps, 0, sizeof(openStamps));
+    openStamps[TRACE_ISR] = irqUs;
+    openStamps[TRACE_UID_READ] = uidReadUs;
+    traceOpen = irqUs != 0;
+#endif
+}
+
+void latencyTraceMark(TracePoint point) {
+#if LATENCY_TRACE
+    if (!traceOpen || point <= TRACE_UID_READ) return;
+
+    openStamps[point] = esp_timer_get_time();
+
+    if (point == TRACE_INDICATOR) {
+        pushTrace();
+        traceOpen = false;
+    }
+#endif
+}
+
+void latencyTraceCancel() {
+    traceOpen = false;
+}
+
+// =============================================================================
+// CONSUMER (MAIN LOOP)
+// =============================================================================
+
+void latencyTraceCollect() {
+    uint32_t tail = ringTail.load(std::memory_order_relaxed);
+    uint32_t head = ringHead.load(std::memory_order_acquire);
+
+    while (tail != head) {
+        const LatencySample& sample = ring[tail & (LATENCY_RING_SIZE - 1)];
+
+        for (uint8_t row = 0; row < LATENCY_ROW_COUNT; row++) {
+            uint32_t us = sample.us[row];
+            if (us == LATENCY_NO_SAMPLE) continue;
+
+            LatencyHistogram& hist = histograms[row];
+            hist.buckets[bucketIndex(us)]++;
+            hist.count++;
+            if (us > hist.maxUs) hist.maxUs = us;
+        }
+
+        tail++;
+        ringTail.store(tail, std::memory_order_release);
+    }
+}
+
+void printLatencyStats() {
+    latencyTraceCollect();
+
+    Serial.println(F("\n=== Tap Latency (ms) ==="));
+#if !LATENCY_TRACE
+    Serial.println(F("Tracing disabled (LATENCY_TRACE)"));
+#endif
+    Serial.printf("Traces: %lu (dropped: %lu)\n",
+                 histograms[LATENCY_ROW_TOTAL].count,
+                 droppedTraces.load(std::memory_order_relaxed));
+    Serial.printf("%-24s %6s %8s %8s %8s %8s\n", "Stage", "n", "p50", "p95", "p99", "max");
+
+    for (uint8_t row = 0; row < LATENCY_ROW_COUNT; row++) {
+        const LatencyHistogram& hist = histograms[row];
+        Serial.printf("%-24s %6lu %8.1f %8.1f %8.1f %8.1f\n",
+                     rowNames[row], hist.count,
+                     percentile(hist, 50) / 1000.0f,
+                     percentile(hist, 95) / 1000.0f,
+                     percentile(hist, 99) / 1000.0f,
+                     hist.maxUs / 1000.0f);
+    }
+
+    Serial.println(F("========================\n"));
+}
+
+void resetLatencyStats() {
+    latencyTraceCollect();
+    memset(histograms, 0, sizeof(histograms));
+    droppedTraces.store(0, std::memory_order_relaxed);
+}
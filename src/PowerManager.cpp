@@ -0,0 +1,158 @@
+/*
+ * TapTrack - Power Manager Implementation
+ * Light sleep between idle card polls, Wi-Fi modem sleep between syncs
+ */
+
+#include "PowerManager.h"
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <driver/gpio.h>
+#include <driver/uart.h>
+
+// =============================================================================
+// STATE
+// =============================================================================
+
+static volatile bool lowPowerAllowed = false;
+static volatile unsigned long lastActivity = 0;
+
+static PowerStats powerStats = {};
+static int64_t statsSince = 0;
+
+// =============================================================================
+// PUBLIC FUNCTIONS
+// =============================================================================
+
+void initPower() {
+    // Level wake source (idle high). The button is polled, so its level
+    // trigger can stay. The card IRQ is not one: the field is off while
+    // asleep, so no card can answer - the poll timer finds them instead.
+    gpio_wakeup_enable((gpio_num_t)MODE_BUTTON_PIN, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+
+    // Serial input wakes too (the first characters are lost)
+    uart_set_wakeup_threshold(UART_NUM_0, 3);
+    esp_sleep_enable_uart_wakeup(UART_NUM_0);
+
+    lastActivity = millis();
+    statsSince = esp_timer_get_time();
+
+    Serial.printf("✓ Power manager (light sleep: %s, modem sleep: %s)\n",
+                 POWER_LIGHT_SLEEP ? "on" : "off",
+                 POWER_MODEM_SLEEP ? "on" : "off");
+}
+
+void setLowPowerAllowed(bool allowed) {
+    lowPowerAllowed = allowed;
+}
+
+void notePowerActivity() {
+    lastActivity = millis();
+}
+
+bool isPowerIdle() {
+#if POWER_LIGHT_SLEEP
+    bool idle = lowPowerAllowed && (millis() - lastActivity >= POWER_IDLE_AFTER_MS);
+    powerStats.lowPowerIdle = idle;
+    return idle;
+#else
+    return false;
+#endif
+}
+
+uint32_t lightSleepFor(uint32_t ms) {
+    // UART output would be garbled across the clock gating
+    Serial.flush();
+
+    esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+
+    int64_t start = esp_timer_get_time();
+    esp_light_sleep_start();
+    int64_t slept = esp_timer_get_time() - start;
+
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+
+    powerStats.sleepCount++;
+    powerStats.sleepTimeUs += slept;
+
+    switch (cause) {
+        case ESP_SLEEP_WAKEUP_TIMER: {
+            powerStats.timerWakeCount++;
+            int64_t overshoot = slept - (int64_t)ms * 1000;
+            uint32_t latency = overshoot > 0 ? (uint32_t)overshoot : 0;
+            powerStats.lastWakeLatencyUs = latency;
+            if (latency > powerStats.maxWakeLatencyUs) {
+                powerStats.maxWakeLatencyUs = latency;
+            }
+            break;
+        }
+
+        case ESP_SLEEP_WAKEUP_GPIO:
+            powerStats.gpioWakeCount++;
+            notePowerActivity();
+            break;
+
+        case ESP_SLEEP_WAKEUP_UART:
+            powerStats.uartWakeCount++;
+            notePowerActivity();
+            break;
+
+        default:
+            break;
+    }
+
+    return cause;
+}
+
+void setNetworkBusy(bool busy) {
+#if POWER_MODEM_SLEEP
+    // Compared against the driver, not a cached flag: every WiFi.mode()
+    // start re-applies the Arduino default (WIFI_PS_MIN_MODEM)
+    wifi_ps_type_t want = busy ? WIFI_PS_NONE : WIFI_PS_MIN_MODEM;
+    wifi_ps_type_t current;
+    if (esp_wifi_get_ps(&current) != ESP_OK) return;    // Wi-Fi not started
+
+    if (current != want && esp_wifi_set_ps(want) == ESP_OK) {
+        current = want;
+    }
+    powerStats.modemSleep = current != WIFI_PS_NONE;
+#endif
+}
+
+PowerStats getPowerStats() {
+    PowerStats stats = powerStats;
+    stats.trackedTimeUs = esp_timer_get_time() - statsSince;
+    return stats;
+}
+
+void printPowerStats() {
+    PowerStats stats = getPowerStats();
+
+    Serial.println(F("\n=== Power ==="));
+    Serial.printf("Light sleep: %s (%s)\n",
+                 POWER_LIGHT_SLEEP ? "enabled" : "disabled",
+                 stats.lowPowerIdle ? "idle, duty-cycling" :
+                 lowPowerAllowed ? "waiting for idle" : "radio in use");
+    Serial.printf("Modem sleep: %s\n", stats.modemSleep ? "on" : "off");
+    Serial.printf("Sleep residency: %.1f%% (%lu sleeps over %lu s)\n",
+                 stats.trackedTimeUs ? stats.sleepTimeUs * 100.0f / stats.trackedTimeUs : 0.0f,
+                 stats.sleepCount, (unsigned long)(stats.trackedTimeUs / 1000000));
+    Serial.printf("Wakes: timer %lu, gpio %lu, uart %lu\n",
+                 stats.timerWakeCount, stats.gpioWakeCount, stats.uartWakeCount);
+    Serial.printf("Wake latency: last %lu us, max %lu us\n",
+                 stats.lastWakeLatencyUs, stats.maxWakeLatencyUs);
+    Serial.printf("Worst-case idle detect delay: %d ms\n",
+                 POWER_POLL_MS + 2 * RFID_FIELD_SETTLE_MS);
+    Serial.println(F("=============\n"));
+}
+
+void resetPowerStats() {
+    bool idle = powerStats.lowPowerIdle;
+    bool modem = powerStats.modemSleep;
+
+    powerStats = {};
+    powerStats.lowPowerIdle = idle;
+    powerStats.modemSleep = modem;
+    statsSince = esp_timer_get_time();
+}
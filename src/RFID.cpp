@@ -4,18 +4,84 @@
  */
 
 #include "RFID.h"
+#include "gpio.h"
+#include "PowerManager.h"
+#include <esp_timer.h>
+#include <freertos/queue.h>
 
 // =============================================================================
 // GLOBAL VARIABLES
 // =============================================================================
 
-volatile bool cardDetected = false;
 static byte regVal = 0x7F;
-static unsigned long lastReset = 0;
+
+// Card task
+static TaskHandle_t cardTaskHandle = nullptr;
+static QueueHandle_t cardTapQueue = nullptr;
+static volatile int64_t irqAtUs = 0;
+static volatile bool irqArmed = true;   // Stamp only the first edge per read
+static bool rfidHealthy = true;
+static bool antennaOff = false;     // Field dropped between idle polls
+
+// Health probe state
+static unsigned long lastHealthCheck = 0;
+static unsigned long lastTxHeartbeat = 0;
+static uint8_t probeFailures = 0;
+static RFIDStats rfidStats = {};
 
 // MFRC522 instance
 MFRC522 mfrc522(RFID_SS_PIN, RFID_RST_PIN);
 
+// Same clock as the library's own transfers (-D MFRC522_SPICLOCK)
+static const SPISettings rfidSpiSettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0);
+
+// =============================================================================
+// SPI REGISTER BATCHING
+// =============================================================================
+
+typedef struct {
+    MFRC522::PCD_Register reg;
+    byte value;
+} RegWrite;
+
+/**
+ * Write several registers inside one SPI transaction
+ * A multi-byte CS frame only ever feeds one address (e.g. the FIFO), so
+ * each register still gets its own frame, but bus locking and clock
+ * setup happen once per batch instead of once per register.
+ */
+static void writeRegisters(const RegWrite* writes, uint8_t count) {
+    SPI.beginTransaction(rfidSpiSettings);
+    for (uint8_t i = 0; i < count; i++) {
+        gpio_write(RFID_SS_PIN, 0);
+        SPI.transfer(writes[i].reg);
+        SPI.transfer(writes[i].value);
+        gpio_write(RFID_SS_PIN, 1);
+    }
+    SPI.endTransaction();
+}
+
+static void writeRegister(MFRC522::PCD_Register reg, byte value) {
+    RegWrite write = {reg, value};
+    writeRegisters(&write, 1);
+}
+
+/**
+ * Read several different registers in a single CS frame
+ * Each address byte clocks out the value of the previous address.
+ */
+static void readRegisters(const MFRC522::PCD_Register* regs, byte* values, uint8_t count) {
+    SPI.beginTransaction(rfidSpiSettings);
+    gpio_write(RFID_SS_PIN, 0);
+    SPI.transfer(0x80 | regs[0]);
+    for (uint8_t i = 1; i < count; i++) {
+        values[i - 1] = SPI.transfer(0x80 | regs[i]);
+    }
+    values[count - 1] = SPI.transfer(0x00);
+    gpio_write(RFID_SS_PIN, 1);
+    SPI.endTransaction();
+}
+
 // =============================================================================
 // INITIALIZATION
 // =============================================================================
@@ -25,14 +91,16 @@ void initRFID() {
     
     // Verify module is responding
     byte version = mfrc522.PCD_ReadRegister(mfrc522.VersionReg);
-    if (version == 0x00 || version == 0xFF) {
+    rfidHealthy = !(version == 0x00 || version == 0xFF);
+    if (!rfidHealthy) {
         Serial.println(F("⚠️ WARNING: MFRC522 not detected!"));
     } else {
         Serial.print(F("✓ MFRC522 firmware version: 0x"));
         Serial.println(version, HEX);
     }
     
-    lastReset = millis();
+    lastHealthCheck = millis();
+    lastTxHeartbeat = lastHealthCheck;
 }
 
 // =============================================================================
@@ -40,52 +108,180 @@ void initRFID() {
 // =============================================================================
 
 void IRAM_ATTR readCardISR() {
-    cardDetected = true;
+    if (irqArmed) {
+        irqAtUs = esp_timer_get_time();
+        irqArmed = false;
+    }
+    
+    if (cardTaskHandle) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(cardTaskHandle, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
 }
 
 void activateRec() {
-    mfrc522.PCD_WriteRegister(mfrc522.FIFODataReg, mfrc522.PICC_CMD_REQA);
-    mfrc522.PCD_WriteRegister(mfrc522.CommandReg, mfrc522.PCD_Transceive);
-    mfrc522.PCD_WriteRegister(mfrc522.BitFramingReg, 0x87);
+    static const RegWrite reqa[] = {
+        {MFRC522::FIFODataReg, MFRC522::PICC_CMD_REQA},
+        {MFRC522::CommandReg, MFRC522::PCD_Transceive},
+        {MFRC522::BitFramingReg, 0x87},     // StartSend, 7-bit short frame
+    };
+    writeRegisters(reqa, 3);
 }
 
 void clearInt() {
-    mfrc522.PCD_WriteRegister(mfrc522.ComIrqReg, 0x7F);
+    writeRegister(MFRC522::ComIrqReg, 0x7F);
 }
 
 void enableInterrupt() {
     regVal = 0xA0;  // RX IRQ
-    mfrc522.PCD_WriteRegister(mfrc522.ComIEnReg, regVal);
+    writeRegister(MFRC522::ComIEnReg, regVal);
 }
 
 // =============================================================================
-// CARD READING
+// CARD TASK
 // =============================================================================
 
-String readCardUID() {
-    // Attempt to read the card serial
-    if (!mfrc522.PICC_ReadCardSerial()) {
-        return "";
+/**
+ * Read the field after an IRQ and post one tap per card
+ */
+static void handleCardIrq() {
+    CardUid uids[RFID_MAX_CARDS_PER_FIELD];
+    
+    CardTap tap;
+    tap.detectedAtUs = irqAtUs;
+    int64_t start = esp_timer_get_time();
+    uint8_t count = readCardUIDs(uids, RFID_MAX_CARDS_PER_FIELD);
+    tap.readAtUs = esp_timer_get_time();
+    
+    clearInt();
+
+    // The read's own transceives raised RxIRq again - drop those edges,
+    // or the next wait returns at once and posts an empty tap. Nothing
+    // new can answer before the next activateRec().
+    ulTaskNotifyTake(pdTRUE, 0);
+    irqArmed = true;
+
+    uint32_t spiUs = esp_timer_get_time() - start;
+    rfidStats.tapReadCount++;
+    rfidStats.lastTapReadUs = spiUs;
+    rfidStats.totalTapReadUs += spiUs;
+    if (spiUs > rfidStats.maxTapReadUs) rfidStats.maxTapReadUs = spiUs;
+    
+    // A failed read still goes to the tap task so the user gets feedback
+    uint8_t posts = count > 0 ? count : 1;
+    for (uint8_t i = 0; i < posts; i++) {
+        tap.uid = count > 0 ? uids[i] : CardUid();
+        if (xQueueSend(cardTapQueue, &tap, 0) != pdTRUE) {
+            rfidStats.droppedTaps++;
+            Serial.println(F("⚠️ Tap queue full, tap dropped"));
+        }
+    }
+}
+
+/**
+ * One idle duty cycle: field on, REQA, short IRQ window, field off, sleep
+ */
+static void idlePollCycle() {
+    if (antennaOff) {
+        mfrc522.PCD_AntennaOn();
+        antennaOff = false;
+        vTaskDelay(pdMS_TO_TICKS(RFID_FIELD_SETTLE_MS));
+    }
+    activateRec();
+    
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RFID_FIELD_SETTLE_MS)) > 0) {
+        handleCardIrq();
+        notePowerActivity();
+        return;
     }
     
-    String uidStr = "";
+    // Probe while the field is still up (it checks TxControlReg)
+    checkAndResetMFRC522();
+    mfrc522.PCD_AntennaOff();
+    antennaOff = true;
     
-    // Build UID string from bytes
-    for (byte i = 0; i < mfrc522.uid.size; i++) {
-        if (mfrc522.uid.uidByte[i] < 0x10) {
-            uidStr += "0";
+    lightSleepFor(POWER_POLL_MS);
+}
+
+static void cardTask(void* param) {
+    for (;;) {
+        if (isPowerIdle()) {
+            idlePollCycle();
+            continue;
+        }
+        
+        if (antennaOff) {
+            mfrc522.PCD_AntennaOn();
+            antennaOff = false;
+        }
+        
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RFID_POLL_MS)) > 0) {
+            handleCardIrq();
         }
-        uidStr += String(mfrc522.uid.uidByte[i], HEX);
+        
+        int64_t start = esp_timer_get_time();
+        checkAndResetMFRC522();
+        activateRec();
+        rfidStats.lastPollUs = esp_timer_get_time() - start;
     }
-    uidStr.toUpperCase();
+}
+
+void startCardTask() {
+    if (cardTaskHandle) return;
     
-    // Halt the card
-    mfrc522.PICC_HaltA();
+    cardTapQueue = xQueueCreate(RFID_TAP_QUEUE_LEN, sizeof(CardTap));
+    xTaskCreatePinnedToCore(cardTask, "card", RFID_TASK_STACK, nullptr,
+                            RFID_TASK_PRIORITY, &cardTaskHandle, RFID_TASK_CORE);
+}
+
+bool takeCardTap(CardTap& tap, TickType_t wait) {
+    if (!cardTapQueue) return false;
+    return xQueueReceive(cardTapQueue, &tap, wait) == pdTRUE;
+}
+
+// =============================================================================
+// CARD READING
+// =============================================================================
+
+CardUid readCardUID() {
+    CardUid uid;
+    readCardUIDs(&uid, 1);
+    return uid;
+}
+
+uint8_t readCardUIDs(CardUid* uids, uint8_t maxCards) {
+    uint8_t count = 0;
+    
+    while (count < maxCards) {
+        // The first card already answered the idle REQA that raised the
+        // IRQ. After that, REQA only wakes cards still in IDLE - every card
+        // we read is halted, so this walks the rest of the field.
+        if (count > 0 && !mfrc522.PICC_IsNewCardPresent()) {
+            break;
+        }
+        
+        // Anticollision + select (the library resolves bit collisions)
+        if (!mfrc522.PICC_ReadCardSerial()) {
+            break;
+        }
+        
+        uids[count++] = CardUid(mfrc522.uid.uidByte, mfrc522.uid.size);
+        
+        // Halt the card so it stays quiet for the rest of the inventory
+        mfrc522.PICC_HaltA();
+    }
+    
+    #if DEBUG_RFID
+    if (count > 1) {
+        Serial.printf("📇 %d cards in field\n", count);
+    }
+    #endif
     
     // Clear buffer for next read
     clearUIDBuffer();
     
-    return uidStr;
+    return count;
 }
 
 void dump_byte_array(byte *buffer, byte bufferSize) {
@@ -110,33 +306,108 @@ void clearUIDBuffer() {
     mfrc522.uid.sak = 0;
     
     // Optional: Flush the FIFO buffer
-    mfrc522.PCD_WriteRegister(mfrc522.FIFOLevelReg, 0x80);
+    writeRegister(MFRC522::FIFOLevelReg, 0x80);
 }
 
 // =============================================================================
 // HEALTH CHECK & RESET
 // =============================================================================
 
-void checkAndResetMFRC522() {
-    // Reset module periodically to prevent lockups
-    if (millis() - lastReset > RFID_RESET_INTERVAL_MS) {
-        mfrc522.PCD_Init();
-        enableInterrupt();
-        lastReset = millis();
-        
-        #if DEBUG_RFID
-        Serial.println(F("🔄 MFRC522 reset"));
-        #endif
+/**
+ * Read back the registers a healthy, polling MFRC522 must hold
+ * @return RFID_FAULT_* bits (0 = healthy)
+ */
+static uint8_t probeRFID() {
+    static const MFRC522::PCD_Register regs[] = {
+        MFRC522::VersionReg, MFRC522::ComIEnReg,
+        MFRC522::TxControlReg, MFRC522::ComIrqReg
+    };
+    byte values[4];
+    uint8_t faults = 0;
+    unsigned long now = millis();
+    
+    // All four registers in one CS frame
+    readRegisters(regs, values, 4);
+    
+    byte version = values[0];
+    if (version == 0x00 || version == 0xFF) {
+        faults |= RFID_FAULT_VERSION;
+    }
+    
+    // A soft reset/brown-out restores ComIEnReg to 0x80
+    if (values[1] != regVal) {
+        faults |= RFID_FAULT_IRQ_CONFIG;
     }
+    
+    if ((values[2] & 0x03) != 0x03) {
+        faults |= RFID_FAULT_ANTENNA;
+    }
+    
+    // Every activateRec() REQA raises TxIRq once sent; clear it so the
+    // next probe sees a fresh one
+    byte irq = values[3];
+    if (irq & 0x40) {
+        lastTxHeartbeat = now;
+        writeRegister(MFRC522::ComIrqReg, 0x40);
+    } else if (now - lastTxHeartbeat > RFID_HEARTBEAT_TIMEOUT_MS) {
+        faults |= RFID_FAULT_HEARTBEAT;
+    }
+    
+    return faults;
 }
 
-bool isRFIDHealthy() {
-    byte version = mfrc522.PCD_ReadRegister(mfrc522.VersionReg);
+static void reinitRFID() {
+    unsigned long start = millis();
     
-    // Known valid versions: 0x91 (v1.0), 0x92 (v2.0), 0x88 (clone)
-    if (version == 0x00 || version == 0xFF) {
-        return false;
+    mfrc522.PCD_Init();
+    enableInterrupt();
+    
+    unsigned long now = millis();
+    rfidStats.reinitCount++;
+    rfidStats.blindTimeMs += now - start;
+    rfidStats.lastReinitAt = now;
+    lastTxHeartbeat = now;
+    probeFailures = 0;
+}
+
+void checkAndResetMFRC522() {
+    unsigned long now = millis();
+    if (now - lastHealthCheck < RFID_HEALTH_CHECK_MS) return;
+    
+    // Not called for a while (card/upload in progress), so no REQAs were
+    // sent either - restart the heartbeat window instead of flagging it
+    if (now - lastHealthCheck > 2 * RFID_HEALTH_CHECK_MS) {
+        lastTxHeartbeat = now;
+    }
+    lastHealthCheck = now;
+    
+    rfidStats.probeCount++;
+    uint8_t faults = probeRFID();
+    rfidHealthy = (faults & RFID_FAULT_VERSION) == 0;
+    
+    if (faults == 0) {
+        probeFailures = 0;
+        return;
     }
     
-    return true;
+    rfidStats.probeFailCount++;
+    rfidStats.lastFaults = faults;
+    
+    #if DEBUG_RFID
+    Serial.printf("⚠️ MFRC522 probe failed (0x%02X)\n", faults);
+    #endif
+    
+    if (++probeFailures < RFID_PROBE_FAIL_LIMIT) return;
+    
+    Serial.printf("🔄 MFRC522 wedged (faults 0x%02X), reinitializing\n", faults);
+    reinitRFID();
+}
+
+RFIDStats getRFIDStats() {
+    return rfidStats;
+}
+
+bool isRFIDHealthy() {
+    // The card task owns SPI; report what the last probe saw
+    return rfidHealthy;
 }
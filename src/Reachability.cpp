@@ -0,0 +1,256 @@
+/*
+ * TapTrack - Reachability Probe Implementation
+ * Non-blocking DNS lookup + TCP connect to the RTDB host
+ */
+
+#include "Reachability.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <lwip/dns.h>
+#include <lwip/sockets.h>
+
+// =============================================================================
+// STATE
+// =============================================================================
+
+typedef enum {
+    PROBE_IDLE,
+    PROBE_RESOLVING,
+    PROBE_CONNECTING
+} ProbeState;
+
+static char probeHost[64] = "";
+static uint16_t probePort = 443;
+
+static ProbeState probeState = PROBE_IDLE;
+static bool linkUp = false;
+static uint8_t failStreak = 0;
+static int probeSocket = -1;
+static unsigned long probeStart = 0;
+static unsigned long nextProbeAt = 0;
+
+static ReachabilityStats reachStats = {};
+
+// DNS answers arrive on the lwIP thread; dnsMux guards these
+static portMUX_TYPE dnsMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t dnsGeneration = 0;     // Answers for older lookups are dropped
+static bool dnsDone = false;
+static bool dnsOk = false;
+static ip_addr_t dnsAddr;
+
+// =============================================================================
+// PRIVATE HELPERS
+// =============================================================================
+
+static void setReachable(bool reachable) {
+    if (reachable == reachStats.reachable) return;
+    
+    reachStats.reachable = reachable;
+    reachStats.changes++;
+    reachStats.lastChangeMs = millis();
+    Serial.printf("%s RTDB host %s\n", reachable ? "🌍" : "🚫",
+                 reachable ? "reachable" : "unreachable");
+}
+
+static void closeProbeSocket() {
+    if (probeSocket < 0) return;
+    
+    // Reset instead of FIN: nothing left in TIME_WAIT on either side
+    struct linger reset = {1, 0};
+    setsockopt(probeSocket, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+    close(probeSocket);
+    probeSocket = -1;
+}
+
+static void finishProbe(bool ok) {
+    closeProbeSocket();
+    probeState = PROBE_IDLE;
+    
+    unsigned long now = millis();
+    reachStats.lastProbeMs = now - probeStart;
+    
+    if (ok) {
+        failStreak = 0;
+        setReachable(true);
+        nextProbeAt = now + REACH_PROBE_INTERVAL_MS;
+    } else {
+        reachStats.failures++;
+        if (++failStreak >= REACH_FAIL_LIMIT) {
+            setReachable(false);
+        }
+        nextProbeAt = now + REACH_RETRY_MS;
+    }
+}
+
+static void onDnsFound(const char* name, const ip_addr_t* addr, void* arg) {
+    portENTER_CRITICAL(&dnsMux);
+    if ((uint32_t)(uintptr_t)arg == dnsGeneration) {
+        dnsOk = addr != nullptr;
+        if (addr) dnsAddr = *addr;
+        dnsDone = true;
+    }
+    portEXIT_CRITICAL(&dnsMux);
+}
+
+static void startConnect(const ip_addr_t& addr) {
+    if (!IP_IS_V4(&addr)) {
+        finishProbe(false);
+        return;
+    }
+    
+    struct sockaddr_in target = {};
+    target.sin_family = AF_INET;
+    target.sin_port = htons(probePort);
+    target.sin_addr.s_addr = ip_2_ip4(&addr)->addr;
+    
+    probeSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (probeSocket < 0) {
+        finishProbe(false);
+        return;
+    }
+    fcntl(probeSocket, F_SETFL, fcntl(probeSocket, F_GETFL, 0) | O_NONBLOCK);
+    
+    if (connect(probeSocket, (struct sockaddr*)&target, sizeof(target)) == 0) {
+        finishProbe(true);
+    } else if (errno == EINPROGRESS) {
+        probeState = PROBE_CONNECTING;
+    } else {
+        finishProbe(false);
+    }
+}
+
+static void startProbe() {
+    reachStats.probes++;
+    probeStart = millis();
+    
+    portENTER_CRITICAL(&dnsMux);
+    uint32_t generation = ++dnsGeneration;
+    dnsDone = false;
+    portEXIT_CRITICAL(&dnsMux);
+    
+    // Same unlocked lwIP call WiFi.hostByName() makes, without its wait
+    ip_addr_t addr;
+    err_t err = dns_gethostbyname(probeHost, &addr, onDnsFound, (void*)(uintptr_t)generation);
+    
+    if (err == ERR_OK) {
+        startConnect(addr);
+    } else if (err == ERR_INPROGRESS) {
+        probeState = PROBE_RESOLVING;
+    } else {
+        finishProbe(false);
+    }
+}
+
+static void pollResolve() {
+    bool done, ok;
+    ip_addr_t addr;
+    
+    portENTER_CRITICAL(&dnsMux);
+    done = dnsDone;
+    ok = dnsOk;
+    addr = dnsAddr;
+    portEXIT_CRITICAL(&dnsMux);
+    
+    if (!done) return;
+    if (ok) {
+        startConnect(addr);
+    } else {
+        finishProbe(false);
+    }
+}
+
+static void pollConnect() {
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(probeSocket, &writable);
+    struct timeval noWait = {0, 0};
+    
+    int ready = select(probeSocket + 1, nullptr, &writable, nullptr, &noWait);
+    if (ready > 0) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(probeSocket, SOL_SOCKET, SO_ERROR, &error, &len);
+        finishProbe(error == 0);
+    } else if (ready < 0) {
+        finishProbe(false);
+    }
+}
+
+// =============================================================================
+// PUBLIC FUNCTIONS
+// =============================================================================
+
+void initReachability(const char* url) {
+    const char* host = strstr(url, "://");
+    host = host ? host + 3 : url;
+    probePort = strncmp(url, "http://", 7) == 0 ? 80 : 443;
+    
+    size_t len = strcspn(host, ":/");
+    if (len >= sizeof(probeHost)) len = sizeof(probeHost) - 1;
+    memcpy(probeHost, host, len);
+    probeHost[len] = '\0';
+    
+    if (host[len] == ':') {
+        probePort = atoi(host + len + 1);
+    }
+    
+    Serial.printf("✓ Reachability probe: %s:%u\n", probeHost, probePort);
+}
+
+void setReachabilityLink(bool up) {
+    linkUp = up;
+    failStreak = 0;
+    
+    // Drop any probe in flight; its DNS answer is ignored
+    closeProbeSocket();
+    probeState = PROBE_IDLE;
+    portENTER_CRITICAL(&dnsMux);
+    dnsGeneration++;
+    portEXIT_CRITICAL(&dnsMux);
+    
+    // A new link is assumed good until the immediate probe says otherwise
+    setReachable(up);
+    nextProbeAt = millis();
+}
+
+void requestReachabilityProbe() {
+    if (probeState == PROBE_IDLE) {
+        nextProbeAt = millis();
+    }
+}
+
+void reachabilityLoop() {
+    if (!linkUp || probeHost[0] == '\0') return;
+    
+    unsigned long now = millis();
+    
+    switch (probeState) {
+        case PROBE_IDLE:
+            if ((long)(now - nextProbeAt) >= 0) {
+                startProbe();
+            }
+            break;
+            
+        case PROBE_RESOLVING:
+            pollResolve();
+            break;
+            
+        case PROBE_CONNECTING:
+            pollConnect();
+            break;
+    }
+    
+    // startProbe() may have stamped probeStart after now was read
+    if (probeState != PROBE_IDLE && millis() - probeStart > REACH_PROBE_TIMEOUT_MS) {
+        finishProbe(false);
+    }
+}
+
+bool isHostReachable() {
+    return reachStats.reachable;
+}
+
+ReachabilityStats getReachabilityStats() {
+    return reachStats;
+}
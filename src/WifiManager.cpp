@@ -24,6 +24,29 @@ static bool startOffline = false;
 static String pendingSSID = "";
 static String pendingPassword = "";
 static unsigned long portalStartTime = 0;
+
+// Station link - events arrive on the Arduino event task, linkMux
+// guards the state they share with wifiLoop()
+static portMUX_TYPE linkMux = portMUX_INITIALIZER_UNLOCKED;
+static WiFiLinkStats linkStats = {};
+static String linkSSID = "";
+static String linkPassword = "";
+static bool reconnectEnabled = false;
+static bool eventsRegistered = false;
+static bool lastReportedUp = false;
+static unsigned long attemptStart = 0;
+static unsigned long retryAt = 0;
+static uint32_t nextBackoffMs = WIFI_RECONNECT_MS;
+static WiFiLinkCallback linkCallback = nullptr;
+
+// Fast connect
+static WiFiLinkCache linkCache = {};
+static bool linkCacheLoaded = false;
+static bool linkCacheValid = false;
+static bool attemptFast = false;        // Current attempt is directed
+static bool attemptAssociated = false;  // ... and has reached the AP (DHCP may be running)
+static bool fastFailed = false;         // Full scan until the link is up again
+static unsigned long offlineSince = 0;  // millis() of the last drop (0 = boot)
 // =============================================================================
 // HTML TEMPLATES - REFINED MODERN UI
 // =============================================================================
@@ -867,6 +890,230 @@ static void handleOffline() {
     ESP.restart();
 }
 
+// =============================================================================
+// LINK STATE MACHINE
+// =============================================================================
+
+/**
+ * Schedule the next attempt and grow the backoff (linkMux held)
+ */
+static void scheduleRetry() {
+    linkStats.state = WIFI_LINK_BACKOFF;
+    linkStats.backoffMs = nextBackoffMs;
+    retryAt = millis() + nextBackoffMs;
+    nextBackoffMs = min((uint32_t)(nextBackoffMs * 2), (uint32_t)WIFI_RECONNECT_MAX_MS);
+}
+
+static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            portENTER_CRITICAL(&linkMux);
+            linkStats.state = WIFI_LINK_CONNECTED;
+            linkStats.connects++;
+            linkStats.lastConnectMs = millis() - attemptStart;
+            linkStats.lastOnlineMs = millis() - offlineSince;
+            linkStats.lastConnectFast = attemptFast;
+            if (attemptFast) linkStats.fastConnects++;
+            nextBackoffMs = WIFI_RECONNECT_MS;
+            fastFailed = false;
+            portEXIT_CRITICAL(&linkMux);
+            break;
+            
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+            // The directed part worked; DHCP gets the full attempt budget
+            portENTER_CRITICAL(&linkMux);
+            if (linkStats.state == WIFI_LINK_CONNECTING) attemptAssociated = true;
+            portEXIT_CRITICAL(&linkMux);
+            break;
+            
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+            portENTER_CRITICAL(&linkMux);
+            if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+                linkStats.lastReason = info.wifi_sta_disconnected.reason;
+            }
+            if (linkStats.state == WIFI_LINK_CONNECTED) {
+                // First retry after a drop comes quickly, through the cache
+                linkStats.drops++;
+                nextBackoffMs = WIFI_RECONNECT_MS;
+                offlineSince = millis();
+                fastFailed = false;
+            } else if (linkStats.state == WIFI_LINK_CONNECTING && attemptFast) {
+                // AP moved channel/BSSID or went away - scan next time
+                fastFailed = true;
+            }
+            // Ignore the echo of our own disconnects (IDLE/BACKOFF)
+            if (linkStats.state == WIFI_LINK_CONNECTED ||
+                linkStats.state == WIFI_LINK_CONNECTING) {
+                if (reconnectEnabled) scheduleRetry();
+                else linkStats.state = WIFI_LINK_IDLE;
+            }
+            portEXIT_CRITICAL(&linkMux);
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void registerWiFiEvents() {
+    if (eventsRegistered) return;
+    eventsRegistered = true;
+    
+    // Retries are ours (with backoff), not the core's immediate ones
+    WiFi.setAutoReconnect(false);
+    WiFi.onEvent(onWiFiEvent);
+}
+
+static void loadLinkCache() {
+    if (linkCacheLoaded) return;
+    linkCacheLoaded = true;
+    
+    preferences.begin("wifi", true);
+    linkCacheValid = preferences.getBytes("link", &linkCache, sizeof(linkCache)) == sizeof(linkCache);
+    preferences.end();
+}
+
+/**
+ * Cache the current link if it differs from what is stored (main loop)
+ */
+static void saveLinkCache() {
+    WiFiLinkCache cache = {};
+    strlcpy(cache.ssid, WiFi.SSID().c_str(), sizeof(cache.ssid));
+    memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+    cache.channel = WiFi.channel();
+    cache.ip = (uint32_t)WiFi.localIP();
+    cache.gateway = (uint32_t)WiFi.gatewayIP();
+    cache.subnet = (uint32_t)WiFi.subnetMask();
+    cache.dns = (uint32_t)WiFi.dnsIP();
+    
+    loadLinkCache();
+    if (linkCacheValid && memcmp(&cache, &linkCache, sizeof(cache)) == 0) return;
+    
+    preferences.begin("wifi", false);
+    preferences.putBytes("link", &cache, sizeof(cache));
+    preferences.end();
+    
+    linkCache = cache;
+    linkCacheValid = true;
+}
+
+/**
+ * Issue WiFi.begin() (returns right away; the outcome arrives as an event)
+ * Directed with the cached BSSID/channel/IP unless that already failed.
+ */
+static void beginAttempt() {
+    loadLinkCache();
+    bool fast = WIFI_FAST_CONNECT && linkCacheValid && !fastFailed &&
+                linkSSID == linkCache.ssid;
+    
+    portENTER_CRITICAL(&linkMux);
+    linkStats.state = WIFI_LINK_CONNECTING;
+    linkStats.attempts++;
+    if (fast) linkStats.fastAttempts++;
+    attemptFast = fast;
+    attemptAssociated = false;
+    attemptStart = millis();
+    portEXIT_CRITICAL(&linkMux);
+    
+    if (WiFi.getMode() == WIFI_OFF) {
+        WiFi.mode(WIFI_STA);
+    }
+    
+    if (fast) {
+#if WIFI_CACHED_IP
+        WiFi.config(IPAddress(linkCache.ip), IPAddress(linkCache.gateway),
+                    IPAddress(linkCache.subnet), IPAddress(linkCache.dns));
+#endif
+        WiFi.begin(linkSSID.c_str(), linkPassword.c_str(), linkCache.channel, linkCache.bssid);
+    } else {
+        // Back to DHCP and a full scan
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+        WiFi.begin(linkSSID.c_str(), linkPassword.c_str());
+    }
+}
+
+void wifiLoop() {
+    unsigned long now = millis();
+    bool attempt = false;
+    bool timedOut = false;
+    
+    portENTER_CRITICAL(&linkMux);
+    WiFiLinkState state = linkStats.state;
+    if (state == WIFI_LINK_BACKOFF && reconnectEnabled && (long)(now - retryAt) >= 0) {
+        attempt = true;
+    } else if (state == WIFI_LINK_CONNECTING &&
+               now - attemptStart > (attemptFast && !attemptAssociated ?
+                                     WIFI_FAST_TIMEOUT_MS : WIFI_CONNECT_TIMEOUT_MS)) {
+        // Associated but no IP, or the driver never reported back
+        linkStats.timeouts++;
+        // A slow DHCP server is no reason to distrust the cached BSSID/channel
+        if (attemptFast && !attemptAssociated) fastFailed = true;
+        scheduleRetry();
+        timedOut = true;
+    }
+    portEXIT_CRITICAL(&linkMux);
+    
+    if (timedOut) {
+        WiFi.disconnect();
+    }
+    if (attempt) {
+        beginAttempt();
+    }
+    
+    bool up = isWiFiConnected();
+    if (up != lastReportedUp) {
+        lastReportedUp = up;
+        linkStats.lastChangeMs = now;
+        
+        if (up) {
+            WiFiLinkStats stats = getWiFiLinkStats();
+            Serial.printf("⏱️ Online %lu ms after %s (%s connect, %lu ms)\n",
+                         stats.lastOnlineMs, offlineSince ? "link loss" : "boot",
+                         stats.lastConnectFast ? "fast" : "full scan",
+                         stats.lastConnectMs);
+            saveLinkCache();
+        }
+        
+        if (linkCallback) linkCallback(up);
+    }
+}
+
+void setWiFiReconnect(bool enabled) {
+    registerWiFiEvents();
+    
+    if (enabled && linkSSID.length() == 0) {
+        String ssid, password;
+        if (!loadWiFiCredentials(ssid, password)) return;
+        linkSSID = ssid;
+        linkPassword = password;
+    }
+    
+    portENTER_CRITICAL(&linkMux);
+    reconnectEnabled = enabled;
+    if (enabled && linkStats.state == WIFI_LINK_IDLE) {
+        // Start at once; wifiLoop() issues the attempt
+        linkStats.state = WIFI_LINK_BACKOFF;
+        linkStats.backoffMs = 0;
+        retryAt = millis();
+        nextBackoffMs = WIFI_RECONNECT_MS;
+    } else if (!enabled && linkStats.state == WIFI_LINK_BACKOFF) {
+        linkStats.state = WIFI_LINK_IDLE;
+    }
+    portEXIT_CRITICAL(&linkMux);
+}
+
+void setWiFiLinkCallback(WiFiLinkCallback callback) {
+    linkCallback = callback;
+}
+
+WiFiLinkStats getWiFiLinkStats() {
+    portENTER_CRITICAL(&linkMux);
+    WiFiLinkStats stats = linkStats;
+    portEXIT_CRITICAL(&linkMux);
+    return stats;
+}
+
 // =============================================================================
 // PUBLIC FUNCTIONS
 // =============================================================================
@@ -874,6 +1121,8 @@ static void handleOffline() {
 bool initWiFiManager() {
     String ssid, password;
     
+    registerWiFiEvents();
+    
     // Try saved credentials first
     if (loadWiFiCredentials(ssid, password)) {
         Serial.println(F("📶 Found saved WiFi credentials"));
@@ -980,25 +1229,49 @@ bool connectToWiFi(String ssid, String password, uint32_t timeout) {
     Serial.println(ssid);
     
     indicateConnecting(true);
+    registerWiFiEvents();
+    
+    linkSSID = ssid;
+    linkPassword = password;
+    portENTER_CRITICAL(&linkMux);
+    nextBackoffMs = WIFI_RECONNECT_MS;
+    portEXIT_CRITICAL(&linkMux);
+    
+    // Retries inside the timeout go through the state machine
+    bool wasEnabled = reconnectEnabled;
+    reconnectEnabled = true;
     
     WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid.c_str(), password.c_str());
+    beginAttempt();
     
     unsigned long start = millis();
-    while (WiFi.status() != WL_CONNECTED && (millis() - start < timeout)) {
-        delay(500);
-        Serial.print(".");
+    unsigned long lastDot = start;
+    while (!isWiFiConnected() && (millis() - start < timeout)) {
+        wifiLoop();
+        delay(50);
+        if (millis() - lastDot >= 500) {
+            lastDot = millis();
+            Serial.print(".");
+        }
     }
     Serial.println();
     
     indicateConnecting(false);
     
-    if (WiFi.status() == WL_CONNECTED) {
+    if (isWiFiConnected()) {
+        reconnectEnabled = wasEnabled;
         Serial.print(F("✅ Connected! IP: "));
         Serial.println(WiFi.localIP());
         return true;
     }
     
+    // Stop here; setWiFiReconnect() decides whether to keep trying
+    portENTER_CRITICAL(&linkMux);
+    reconnectEnabled = false;
+    linkStats.state = WIFI_LINK_IDLE;
+    portEXIT_CRITICAL(&linkMux);
+    WiFi.disconnect();
+    
     Serial.println(F("❌ Connection failed"));
     return false;
 }
@@ -1008,6 +1281,10 @@ void saveWiFiCredentials(String ssid, String password) {
     preferences.putString("ssid", ssid);
     preferences.putString("password", password);
     preferences.end();
+    
+    if (isWiFiConnected()) {
+        saveLinkCache();
+    }
     Serial.println(F("💾 WiFi credentials saved"));
 }
 
@@ -1023,7 +1300,9 @@ void clearWiFiCredentials() {
     preferences.begin("wifi", false);
     preferences.remove("ssid");
     preferences.remove("password");
+    preferences.remove("link");
     preferences.end();
+    linkCacheValid = false;
     Serial.println(F("🗑️ WiFi credentials cleared"));
 }
 
@@ -1057,18 +1336,15 @@ int getWiFiSignalBars() {
 }
 
 bool isWiFiConnected() {
-    return WiFi.status() == WL_CONNECTED;
+    return linkStats.state == WIFI_LINK_CONNECTED;
 }
 
 void disconnectWiFi() {
+    portENTER_CRITICAL(&linkMux);
+    reconnectEnabled = false;
+    linkStats.state = WIFI_LINK_IDLE;
+    portEXIT_CRITICAL(&linkMux);
+    
     WiFi.disconnect(true);
     Serial.println(F("📴 WiFi disconnected"));
 }
-
-bool reconnectWiFi() {
-    String ssid, password;
-    if (loadWiFiCredentials(ssid, password)) {
-        return connectToWiFi(ssid, password, 10000);
-    }
-    return false;
-}
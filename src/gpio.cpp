@@ -42,4 +42,21 @@ uint8_t gpio_read(uint8_t pin) {
 }
 void delay_us(uint32_t us) {
     esp_rom_delay_us(us);
+}
+
+void gpio_fast_init(uint8_t pin) {
+    gpio_config_t io_conf = {0};
+
+    // Input+output routes the plain GPIO output signal and keeps the
+    // input buffer on; the driver is then switched by register writes
+    io_conf.pin_bit_mask = (1ULL << pin);
+    io_conf.mode         = GPIO_MODE_INPUT_OUTPUT;
+    io_conf.pull_up_en   = GPIO_PULLUP_DISABLE;
+    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    io_conf.intr_type    = GPIO_INTR_DISABLE;
+
+    gpio_config(&io_conf);
+
+    gpio_fast_write(pin, 0);
+    gpio_fast_input(pin);
 }
\ No newline at end of file
@@ -1,39 +1,321 @@
 /*
  * TapTrack - Indicator Module Implementation
  * Non-blocking LED patterns and buzzer feedback
+ *
+ * Every IndicatorState is a constexpr step table (outputs + duration)
+ * in flash, played by a single one-shot esp_timer armed for the next
+ * step boundary - nothing polls. Patterns run on layers:
+ *   background - status/mode patterns (duration 0, until replaced)
+ *   foreground - tap feedback and the startup animation (timed); owns
+ *                the LEDs while it runs, then the background shows again
+ *   sound      - stand-alone beeps
+ * The buzzer is on whenever any layer's current step asks for it.
  */
 
 #include "indicator.h"
 #include "gpio.h"
+#include <esp_timer.h>
 
 // =============================================================================
-// STATE VARIABLES
+// OUTPUTS
 // =============================================================================
 
-static IndicatorState currentState = IND_CLEAR;
-static unsigned long stateStartTime = 0;
-static unsigned long lastBlinkTime = 0;
-static uint16_t stateDuration = 0;
-static bool blinkState = false;
-static bool continuousMode = false;
+#define OUT_GREEN               0x01
+#define OUT_YELLOW              0x02
+#define OUT_RED                 0x04
+#define OUT_BLUE                0x08
+#define OUT_BUZZER              0x10
+#define OUT_ALL_LEDS            (OUT_GREEN | OUT_YELLOW | OUT_RED | OUT_BLUE)
+#define OUT_ALL                 (OUT_ALL_LEDS | OUT_BUZZER)
+#define OUT_COUNT               5
 
+static const uint8_t outputPins[OUT_COUNT] = {
+    LED_GREEN_PIN, LED_YELLOW_PIN, LED_RED_PIN, LED_BLUE_PIN, BUZZER_PIN
+};
+
+// =============================================================================
+// PATTERN TABLES
+// =============================================================================
+
+#define STEP_HOLD               0       // Step duration: stay until the layer ends
+#define NO_LOOP                 0xFF    // Pattern ends after its last step
+
+typedef struct {
+    uint8_t outputs;        // OUT_* bits on during this step (others off)
+    uint16_t ms;            // STEP_HOLD = last step, held
+} IndicatorStep;
+
+typedef struct {
+    const IndicatorStep* steps;
+    uint8_t len;
+    uint8_t loopFrom;       // Step to continue at after the last, or NO_LOOP
+} IndicatorPattern;
+
+#define PATTERN(steps, loopFrom) { steps, sizeof(steps) / sizeof((steps)[0]), loopFrom }
+
+static_assert(2 * BEEP_SUCCESS_MS + BEEP_ERROR_PAUSE_MS < BLINK_SLOW_MS,
+              "Double beep must fit in the first slow blink");
+
+// Success
+static constexpr IndicatorStep STEPS_SUCCESS_ONLINE[] = {
+    {OUT_GREEN | OUT_BUZZER, BEEP_SUCCESS_MS}, {OUT_GREEN, STEP_HOLD}
+};
+static constexpr IndicatorStep STEPS_SUCCESS_OFFLINE[] = {
+    {OUT_YELLOW | OUT_BUZZER, BEEP_SUCCESS_MS}, {OUT_YELLOW, STEP_HOLD}
+};
+static constexpr IndicatorStep STEPS_SUCCESS_QUEUED[] = {
+    {OUT_YELLOW | OUT_BUZZER, BEEP_SUCCESS_MS},
+    {OUT_YELLOW, BLINK_SLOW_MS - BEEP_SUCCESS_MS},
+    {0, BLINK_SLOW_MS},
+    {OUT_YELLOW, BLINK_SLOW_MS}, {0, BLINK_SLOW_MS}                 // Loop
+};
+
+// Errors
+static constexpr IndicatorStep STEPS_ERROR_GENERAL[] = {
+    {OUT_RED, STEP_HOLD}                                            // Silent
+};
+static constexpr IndicatorStep STEPS_ERROR_UNREGISTERED[] = {
+    {OUT_RED | OUT_BUZZER, BEEP_SUCCESS_MS},
+    {OUT_RED, BEEP_ERROR_PAUSE_MS},
+    {OUT_RED | OUT_BUZZER, BEEP_SUCCESS_MS},
+    {OUT_RED, BLINK_SLOW_MS - 2 * BEEP_SUCCESS_MS - BEEP_ERROR_PAUSE_MS},
+    {0, BLINK_SLOW_MS},
+    {OUT_RED, BLINK_SLOW_MS}, {0, BLINK_SLOW_MS}                    // Loop
+};
+static constexpr IndicatorStep STEPS_ERROR_QUEUE_FULL[] = {
+    // Long beep over the first fast blinks
+    {OUT_RED | OUT_BUZZER, BLINK_FAST_MS}, {OUT_BUZZER, BLINK_FAST_MS},
+    {OUT_RED | OUT_BUZZER, BLINK_FAST_MS}, {OUT_BUZZER, BLINK_FAST_MS},
+    {OUT_RED | OUT_BUZZER, BLINK_FAST_MS}, {0, BLINK_FAST_MS},
+    {OUT_RED, BLINK_FAST_MS}, {0, BLINK_FAST_MS}                    // Loop
+};
+static constexpr IndicatorStep STEPS_ERROR_RTC_INVALID[] = {
+    {OUT_RED | OUT_YELLOW | OUT_BUZZER, BEEP_SUCCESS_MS},
+    {OUT_RED | OUT_YELLOW, BEEP_ERROR_PAUSE_MS},
+    {OUT_RED | OUT_YELLOW | OUT_BUZZER, BEEP_SUCCESS_MS},
+    {OUT_RED | OUT_YELLOW, STEP_HOLD}
+};
+
+// Status and mode
+static constexpr IndicatorStep STEPS_BLINK_GREEN_SYNC[] = {
+    {OUT_GREEN, BLINK_SYNC_MS}, {0, BLINK_SYNC_MS}
+};
+static constexpr IndicatorStep STEPS_BLINK_YELLOW_SLOW[] = {
+    {OUT_YELLOW, BLINK_SLOW_MS}, {0, BLINK_SLOW_MS}
+};
+static constexpr IndicatorStep STEPS_BLINK_BLUE_MODE[] = {
+    {OUT_BLUE, BLINK_MODE_MS}, {0, BLINK_MODE_MS}
+};
+static constexpr IndicatorStep STEPS_GREEN[] = { {OUT_GREEN, STEP_HOLD} };
+static constexpr IndicatorStep STEPS_YELLOW[] = { {OUT_YELLOW, STEP_HOLD} };
+static constexpr IndicatorStep STEPS_BLUE[] = { {OUT_BLUE, STEP_HOLD} };
+static constexpr IndicatorStep STEPS_OFF[] = { {0, STEP_HOLD} };
+
+// System
+static constexpr IndicatorStep STEPS_STARTUP[] = {
+    {OUT_GREEN | OUT_BUZZER,  50}, {OUT_GREEN,  200},
+    {OUT_YELLOW | OUT_BUZZER, 50}, {OUT_YELLOW, 200},
+    {OUT_RED | OUT_BUZZER,    50}, {OUT_RED,    200},
+    {OUT_BLUE | OUT_BUZZER,   50}, {OUT_BLUE,   200},
+    {0, 100},
+    {OUT_ALL_LEDS, 300}
+};
+
+// Indexed by IndicatorState
+static constexpr IndicatorPattern patterns[] = {
+    PATTERN(STEPS_SUCCESS_ONLINE, NO_LOOP),         // IND_SUCCESS_ONLINE
+    PATTERN(STEPS_SUCCESS_OFFLINE, NO_LOOP),        // IND_SUCCESS_OFFLINE
+    PATTERN(STEPS_SUCCESS_QUEUED, 3),               // IND_SUCCESS_QUEUED
+    PATTERN(STEPS_ERROR_GENERAL, NO_LOOP),          // IND_ERROR_GENERAL
+    PATTERN(STEPS_ERROR_UNREGISTERED, 5),           // IND_ERROR_UNREGISTERED
+    PATTERN(STEPS_ERROR_QUEUE_FULL, 6),             // IND_ERROR_QUEUE_FULL
+    PATTERN(STEPS_ERROR_RTC_INVALID, NO_LOOP),      // IND_ERROR_RTC_INVALID
+    PATTERN(STEPS_BLINK_GREEN_SYNC, 0),             // IND_STATUS_SYNCING
+    PATTERN(STEPS_BLINK_YELLOW_SLOW, 0),            // IND_STATUS_CONNECTING
+    PATTERN(STEPS_BLUE, NO_LOOP),                   // IND_STATUS_PORTAL_ACTIVE
+    PATTERN(STEPS_BLUE, NO_LOOP),                   // IND_MODE_ONLINE
+    PATTERN(STEPS_OFF, NO_LOOP),                    // IND_MODE_OFFLINE
+    PATTERN(STEPS_BLINK_BLUE_MODE, 0),              // IND_MODE_AUTO
+    PATTERN(STEPS_STARTUP, NO_LOOP),                // IND_STARTUP
+    PATTERN(STEPS_GREEN, NO_LOOP),                  // IND_READY
+    PATTERN(STEPS_YELLOW, NO_LOOP),                 // IND_PROCESSING
+    PATTERN(STEPS_OFF, NO_LOOP)                     // IND_CLEAR
+};
+
+static_assert(sizeof(patterns) / sizeof(patterns[0]) == IND_CLEAR + 1,
+              "One pattern per IndicatorState");
+
+// Stand-alone beeps (sound layer)
+static constexpr IndicatorStep STEPS_BEEP_SUCCESS[] = { {OUT_BUZZER, BEEP_SUCCESS_MS} };
+static constexpr IndicatorStep STEPS_BEEP_ERROR[] = {
+    {OUT_BUZZER, BEEP_ERROR_MS}, {0, BEEP_ERROR_PAUSE_MS}, {OUT_BUZZER, BEEP_ERROR_MS}
+};
+static constexpr IndicatorStep STEPS_BEEP_DOUBLE[] = {
+    {OUT_BUZZER, BEEP_SUCCESS_MS}, {0, BEEP_ERROR_PAUSE_MS}, {OUT_BUZZER, BEEP_SUCCESS_MS}
+};
+static constexpr IndicatorStep STEPS_BEEP_LONG[] = { {OUT_BUZZER, BEEP_LONG_MS} };
+
+static constexpr IndicatorPattern PATTERN_BEEP_SUCCESS = PATTERN(STEPS_BEEP_SUCCESS, NO_LOOP);
+static constexpr IndicatorPattern PATTERN_BEEP_ERROR = PATTERN(STEPS_BEEP_ERROR, NO_LOOP);
+static constexpr IndicatorPattern PATTERN_BEEP_DOUBLE = PATTERN(STEPS_BEEP_DOUBLE, NO_LOOP);
+static constexpr IndicatorPattern PATTERN_BEEP_LONG = PATTERN(STEPS_BEEP_LONG, NO_LOOP);
+
+// =============================================================================
+// PLAYER STATE
 // =============================================================================
-// PRIVATE HELPERS
+
+typedef enum {
+    LAYER_BACKGROUND,
+    LAYER_FOREGROUND,
+    LAYER_SOUND,
+    LAYER_COUNT
+} IndicatorLayerId;
+
+typedef struct {
+    const IndicatorPattern* pattern;    // nullptr = layer idle
+    uint8_t index;
+    int64_t stepEndUs;                  // 0 = held step
+    int64_t endUs;                      // 0 = no time limit
+} IndicatorLayer;
+
+// Callers on both cores plus the esp_timer task; playerMux guards all
+static portMUX_TYPE playerMux = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t playerTimer = nullptr;
+static IndicatorLayer layers[LAYER_COUNT];
+static uint8_t currentOutputs = 0;
+
+// Backing pattern for beep(duration)
+static IndicatorStep customBeepStep;
+static const IndicatorPattern customBeepPattern = { &customBeepStep, 1, NO_LOOP };
+
 // =============================================================================
+// PRIVATE HELPERS (playerMux held)
+// =============================================================================
+
+static void writeOutputs(uint8_t outputs) {
+    uint8_t changed = outputs ^ currentOutputs;
+    for (uint8_t i = 0; i < OUT_COUNT; i++) {
+        uint8_t bit = 1 << i;
+        if (changed & bit) gpio_fast_write(outputPins[i], outputs & bit);
+    }
+    currentOutputs = outputs;
+}
+
+static uint8_t layerOutputs(IndicatorLayerId id) {
+    const IndicatorLayer& layer = layers[id];
+    return layer.pattern ? layer.pattern->steps[layer.index].outputs : 0;
+}
+
+/**
+ * LEDs from the top active layer, buzzer from any layer
+ */
+static void composeOutputs() {
+    uint8_t leds = layers[LAYER_FOREGROUND].pattern ?
+                   layerOutputs(LAYER_FOREGROUND) : layerOutputs(LAYER_BACKGROUND);
+    
+    uint8_t buzzer = 0;
+    for (uint8_t i = 0; i < LAYER_COUNT; i++) {
+        buzzer |= layerOutputs((IndicatorLayerId)i);
+    }
+    
+    writeOutputs((leds & OUT_ALL_LEDS) | (buzzer & OUT_BUZZER));
+}
+
+/**
+ * Move every layer past the step boundaries that are due
+ */
+static void advanceLayers(int64_t now) {
+    for (uint8_t i = 0; i < LAYER_COUNT; i++) {
+        IndicatorLayer& layer = layers[i];
+        if (!layer.pattern) continue;
+        
+        if (layer.endUs && now >= layer.endUs) {
+            layer.pattern = nullptr;
+            continue;
+        }
+        
+        while (layer.stepEndUs && now >= layer.stepEndUs) {
+            uint8_t next = layer.index + 1;
+            if (next >= layer.pattern->len) {
+                if (layer.pattern->loopFrom == NO_LOOP) {
+                    layer.pattern = nullptr;
+                    break;
+                }
+                next = layer.pattern->loopFrom;
+            }
+            
+            // Advance from the boundary, not from now, so blinks keep cadence
+            layer.index = next;
+            uint16_t ms = layer.pattern->steps[next].ms;
+            layer.stepEndUs = ms ? layer.stepEndUs + (int64_t)ms * 1000 : 0;
+        }
+    }
+}
+
+/**
+ * Arm the timer for the earliest step or layer end
+ */
+static void armTimer(int64_t now) {
+    int64_t next = 0;
+    for (uint8_t i = 0; i < LAYER_COUNT; i++) {
+        const IndicatorLayer& layer = layers[i];
+        if (!layer.pattern) continue;
+        if (layer.stepEndUs && (!next || layer.stepEndUs < next)) next = layer.stepEndUs;
+        if (layer.endUs && (!next || layer.endUs < next)) next = layer.endUs;
+    }
+    
+    esp_timer_stop(playerTimer);
+    if (next) {
+        esp_timer_start_once(playerTimer, next > now ? next - now : 1);
+    }
+}
 
-static void setLED(uint8_t pin, bool state) {
-    gpio_write(pin, state ? 1 : 0);
+static void onPlayerTimer(void* arg) {
+    portENTER_CRITICAL(&playerMux);
+    int64_t now = esp_timer_get_time();
+    advanceLayers(now);
+    composeOutputs();
+    armTimer(now);
+    portEXIT_CRITICAL(&playerMux);
 }
 
-static void allLEDsOff() {
-    setLED(LED_GREEN_PIN, false);
-    setLED(LED_YELLOW_PIN, false);
-    setLED(LED_RED_PIN, false);
-    setLED(LED_BLUE_PIN, false);
+/**
+ * Start a pattern on a layer, replacing what it was playing
+ * @param durationMs - Layer ends after this (0 = when the pattern ends)
+ */
+static void startLayer(IndicatorLayerId id, const IndicatorPattern* pattern, uint16_t durationMs) {
+    if (!playerTimer) return;
+    
+    portENTER_CRITICAL(&playerMux);
+    int64_t now = esp_timer_get_time();
+    IndicatorLayer& layer = layers[id];
+    uint16_t ms = pattern->steps[0].ms;
+    
+    layer.pattern = pattern;
+    layer.index = 0;
+    layer.stepEndUs = ms ? now + (int64_t)ms * 1000 : 0;
+    layer.endUs = durationMs ? now + (int64_t)durationMs * 1000 : 0;
+    
+    composeOutputs();
+    armTimer(now);
+    portEXIT_CRITICAL(&playerMux);
+}
+
+static void stopLayer(IndicatorLayerId id) {
+    portENTER_CRITICAL(&playerMux);
+    layers[id].pattern = nullptr;
+    composeOutputs();
+    if (playerTimer) armTimer(esp_timer_get_time());
+    portEXIT_CRITICAL(&playerMux);
 }
 
-static void buzzerOff() {
-    gpio_write(BUZZER_PIN, 0);
+/**
+ * Drive outputs directly (testIndicators only; layers are cleared first)
+ */
+static void setLED(uint8_t output, bool state) {
+    portENTER_CRITICAL(&playerMux);
+    writeOutputs(state ? currentOutputs | output : currentOutputs & ~output);
+    portEXIT_CRITICAL(&playerMux);
 }
 
 // =============================================================================
@@ -48,181 +330,39 @@ void initIndicator() {
     gpio_pin_init(LED_BLUE_PIN, GPIO_OUTPUT_MODE);
     gpio_pin_init(BUZZER_PIN, GPIO_OUTPUT_MODE);
     
+    if (!playerTimer) {
+        esp_timer_create_args_t args = {};
+        args.callback = onPlayerTimer;
+        args.name = "indicator";
+        esp_timer_create(&args, &playerTimer);
+    }
+    
     // Ensure all outputs are off initially
-    clearIndicators();
+    portENTER_CRITICAL(&playerMux);
+    currentOutputs = OUT_ALL;
+    writeOutputs(0);
+    portEXIT_CRITICAL(&playerMux);
     
     Serial.println(F("✓ Indicator module initialized"));
 }
 
 void setIndicator(IndicatorState state, uint16_t duration) {
-    currentState = state;
-    stateStartTime = millis();
-    stateDuration = duration;
-    lastBlinkTime = millis();
-    blinkState = true;
-    continuousMode = (duration == 0);
-    
-    // Set initial state
-    allLEDsOff();
-    
-    switch (state) {
-        case IND_SUCCESS_ONLINE:
-            setLED(LED_GREEN_PIN, true);
-            beepSuccess();
-            break;
-            
-        case IND_SUCCESS_OFFLINE:
-        case IND_SUCCESS_QUEUED:
-            setLED(LED_YELLOW_PIN, true);
-            beepSuccess();
-            break;
-            
-        case IND_ERROR_GENERAL:
-            setLED(LED_RED_PIN, true);
-            beepError();
-            break;
-            
-        case IND_ERROR_UNREGISTERED:
-            setLED(LED_RED_PIN, true);
-            beepDouble();
-            break;
-            
-        case IND_ERROR_QUEUE_FULL:
-            setLED(LED_RED_PIN, true);
-            beepLong();
-            break;
-            
-        case IND_ERROR_RTC_INVALID:
-            setLED(LED_RED_PIN, true);
-            setLED(LED_YELLOW_PIN, true);
-            beepDouble();
-            break;
-            
-        case IND_STATUS_SYNCING:
-            setLED(LED_GREEN_PIN, true);
-            break;
-            
-        case IND_STATUS_CONNECTING:
-            setLED(LED_YELLOW_PIN, true);
-            break;
-            
-        case IND_STATUS_PORTAL_ACTIVE:
-            setLED(LED_BLUE_PIN, true);
-            break;
-            
-        case IND_STATUS_STREAM_ACTIVE:
-            setLED(LED_BLUE_PIN, true);
-            break;
-            
-        case IND_MODE_ONLINE:
-            setLED(LED_BLUE_PIN, true);
-            break;
-            
-        case IND_MODE_OFFLINE:
-            setLED(LED_BLUE_PIN, false);
-            break;
-            
-        case IND_MODE_AUTO:
-            setLED(LED_BLUE_PIN, true);
-            break;
-            
-        case IND_PROCESSING:
-            setLED(LED_YELLOW_PIN, true);
-            break;
-            
-        case IND_READY:
-            setLED(LED_GREEN_PIN, true);
-            break;
-            
-        case IND_CLEAR:
-        default:
-            allLEDsOff();
-            break;
-    }
-}
-
-void updateIndicator() {
-    unsigned long now = millis();
-    
-    // Check if timed state has expired
-    if (!continuousMode && stateDuration > 0) {
-        if (now - stateStartTime >= stateDuration) {
-            clearIndicators();
-            return;
-        }
-    }
-    
-    // Handle blinking states
-    uint16_t blinkInterval = BLINK_SLOW_MS;
-    bool needsBlink = false;
-    
-    switch (currentState) {
-        case IND_SUCCESS_QUEUED:
-        case IND_ERROR_UNREGISTERED:
-            blinkInterval = BLINK_SLOW_MS;
-            needsBlink = true;
-            break;
-            
-        case IND_ERROR_QUEUE_FULL:
-            blinkInterval = BLINK_FAST_MS;
-            needsBlink = true;
-            break;
-            
-        case IND_STATUS_SYNCING:
-            blinkInterval = BLINK_SYNC_MS;
-            needsBlink = true;
-            break;
-            
-        case IND_STATUS_CONNECTING:
-        case IND_STATUS_STREAM_ACTIVE:
-            blinkInterval = BLINK_SLOW_MS;
-            needsBlink = true;
-            break;
-            
-        case IND_MODE_AUTO:
-            blinkInterval = 1000;  // Very slow blink for mode
-            needsBlink = true;
-            break;
-            
-        default:
-            break;
+    if (state == IND_CLEAR) {
+        clearIndicators();
+        return;
     }
     
-    if (needsBlink && (now - lastBlinkTime >= blinkInterval)) {
-        lastBlinkTime = now;
-        blinkState = !blinkState;
-        
-        switch (currentState) {
-            case IND_SUCCESS_QUEUED:
-            case IND_STATUS_CONNECTING:
-                setLED(LED_YELLOW_PIN, blinkState);
-                break;
-                
-            case IND_ERROR_UNREGISTERED:
-            case IND_ERROR_QUEUE_FULL:
-                setLED(LED_RED_PIN, blinkState);
-                break;
-                
-            case IND_STATUS_SYNCING:
-                setLED(LED_GREEN_PIN, blinkState);
-                break;
-                
-            case IND_STATUS_STREAM_ACTIVE:
-            case IND_MODE_AUTO:
-                setLED(LED_BLUE_PIN, blinkState);
-                break;
-                
-            default:
-                break;
-        }
-    }
+    startLayer(duration ? LAYER_FOREGROUND : LAYER_BACKGROUND, &patterns[state], duration);
 }
 
 void clearIndicators() {
-    currentState = IND_CLEAR;
-    continuousMode = false;
-    allLEDsOff();
-    buzzerOff();
+    portENTER_CRITICAL(&playerMux);
+    for (uint8_t i = 0; i < LAYER_COUNT; i++) {
+        layers[i].pattern = nullptr;
+    }
+    composeOutputs();
+    if (playerTimer) esp_timer_stop(playerTimer);
+    portEXIT_CRITICAL(&playerMux);
 }
 
 // =============================================================================
@@ -268,7 +408,7 @@ void indicateSyncing(bool active) {
     if (active) {
         setIndicator(IND_STATUS_SYNCING, 0);  // Continuous until cleared
     } else {
-        clearIndicators();
+        stopLayer(LAYER_BACKGROUND);
     }
 }
 
@@ -276,7 +416,7 @@ void indicateConnecting(bool active) {
     if (active) {
         setIndicator(IND_STATUS_CONNECTING, 0);
     } else {
-        clearIndicators();
+        stopLayer(LAYER_BACKGROUND);
     }
 }
 
@@ -284,7 +424,7 @@ void indicatePortalActive(bool active) {
     if (active) {
         setIndicator(IND_STATUS_PORTAL_ACTIVE, 0);
     } else {
-        clearIndicators();
+        stopLayer(LAYER_BACKGROUND);
     }
 }
 
@@ -292,7 +432,7 @@ void indicateProcessing(bool active) {
     if (active) {
         setIndicator(IND_PROCESSING, 0);
     } else {
-        clearIndicators();
+        stopLayer(LAYER_BACKGROUND);
     }
 }
 
@@ -316,29 +456,26 @@ void indicateMode(SystemMode mode) {
 // =============================================================================
 
 void beep(uint16_t duration) {
-    gpio_write(BUZZER_PIN, 1);
-    delay(duration);
-    gpio_write(BUZZER_PIN, 0);
+    portENTER_CRITICAL(&playerMux);
+    customBeepStep = {OUT_BUZZER, duration};
+    portEXIT_CRITICAL(&playerMux);
+    startLayer(LAYER_SOUND, &customBeepPattern, 0);
 }
 
 void beepSuccess() {
-    beep(BEEP_SUCCESS_MS);
+    startLayer(LAYER_SOUND, &PATTERN_BEEP_SUCCESS, 0);
 }
 
 void beepError() {
-    // beep(BEEP_ERROR_MS);
-    // delay(BEEP_ERROR_PAUSE_MS);
-    // beep(BEEP_ERROR_MS);
+    startLayer(LAYER_SOUND, &PATTERN_BEEP_ERROR, 0);
 }
 
 void beepDouble() {
-    beep(BEEP_SUCCESS_MS);
-    delay(BEEP_ERROR_PAUSE_MS);
-    beep(BEEP_SUCCESS_MS);
+    startLayer(LAYER_SOUND, &PATTERN_BEEP_DOUBLE, 0);
 }
 
 void beepLong() {
-    beep(500);
+    startLayer(LAYER_SOUND, &PATTERN_BEEP_LONG, 0);
 }
 
 // =============================================================================
@@ -346,30 +483,31 @@ void beepLong() {
 // =============================================================================
 
 void testIndicators() {
+    clearIndicators();
     Serial.println(F("\n🔍 Testing Indicator Module..."));
     
     Serial.println(F("  Testing Green LED..."));
-    setLED(LED_GREEN_PIN, true);
+    setLED(OUT_GREEN, true);
     delay(500);
-    setLED(LED_GREEN_PIN, false);
+    setLED(OUT_GREEN, false);
     delay(200);
     
     Serial.println(F("  Testing Yellow LED..."));
-    setLED(LED_YELLOW_PIN, true);
+    setLED(OUT_YELLOW, true);
     delay(500);
-    setLED(LED_YELLOW_PIN, false);
+    setLED(OUT_YELLOW, false);
     delay(200);
     
     Serial.println(F("  Testing Red LED..."));
-    setLED(LED_RED_PIN, true);
+    setLED(OUT_RED, true);
     delay(500);
-    setLED(LED_RED_PIN, false);
+    setLED(OUT_RED, false);
     delay(200);
     
     Serial.println(F("  Testing Blue LED..."));
-    setLED(LED_BLUE_PIN, true);
+    setLED(OUT_BLUE, true);
     delay(500);
-    setLED(LED_BLUE_PIN, false);
+    setLED(OUT_BLUE, false);
     delay(200);
     
     Serial.println(F("  Testing Buzzer..."));
@@ -383,39 +521,6 @@ void testIndicators() {
 void startupSequence() {
     Serial.println(F("🚀 Startup sequence..."));
     
-    // Green
-    setLED(LED_GREEN_PIN, true);
-    beep(50);
-    delay(200);
-    setLED(LED_GREEN_PIN, false);
-    
-    // Yellow
-    setLED(LED_YELLOW_PIN, true);
-    beep(50);
-    delay(200);
-    setLED(LED_YELLOW_PIN, false);
-    
-    // Red
-    setLED(LED_RED_PIN, true);
-    beep(50);
-    delay(200);
-    setLED(LED_RED_PIN, false);
-    
-    // Blue
-    setLED(LED_BLUE_PIN, true);
-    beep(50);
-    delay(200);
-    setLED(LED_BLUE_PIN, false);
-    
-    // All on briefly
-    allLEDsOff();
-    delay(100);
-    setLED(LED_GREEN_PIN, true);
-    setLED(LED_YELLOW_PIN, true);
-    setLED(LED_RED_PIN, true);
-    setLED(LED_BLUE_PIN, true);
-    delay(300);
-    allLEDsOff();
-    
-    Serial.println(F("✓ Startup complete"));
+    // Plays on while the rest of setup() runs
+    startLayer(LAYER_FOREGROUND, &patterns[IND_STARTUP], 0);
 }
@@ -9,6 +9,7 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include <SPIFFS.h>
+#include <esp_timer.h>
 
 #include "config.h"
 #include "secrets.h"
@@ -20,6 +21,11 @@
 #include "DS1302_RTC.h"
 #include "indicator.h"
 #include "gpio.h"
+#include "LatencyTrace.h"
+#include "TapCooldown.h"
+#include "PowerManager.h"
+#include "TapJournal.h"
+#include "Reachability.h"
 
 // =============================================================================
 // STATE MACHINE DEFINITION
@@ -47,31 +53,43 @@ AttendanceQueue attendanceQueue;
 static SystemState currentState = STATE_INITIALIZE;
 static SystemState previousState = STATE_INITIALIZE;
 
-static SystemMode currentMode = DEFAULT_SYSTEM_MODE;
-static bool isOnline = false;
+// Read by the tap task on the other core
+static volatile SystemMode currentMode = DEFAULT_SYSTEM_MODE;
+static volatile bool isOnline = false;
+static volatile bool queueFull = false;
 bool firebaseInitialized = false;
 
 // State machine data context
 struct StateContext {
-    String cardUID;
+    CardUid cardUID;
     String userName;
-    String timestamp;
+    Timestamp time;
     String attendanceStatus;
     String registrationStatus;
     bool isRegistered;
+    bool firstTapToday;     // Day rollup still owed
+    uint16_t journalSeq;    // Tap journal entry to commit once durable
+    bool fromQueue;         // Head of the offline queue, not a live tap
+    bool pushed;            // /attendance write confirmed
     
     String syncId;
+    String rollupId;
     unsigned long syncStartTime;
     int uploadRetries;
     
     void reset() {
-        cardUID = "";
+        cardUID = CardUid();
         userName = "";
-        timestamp = "";
+        time = Timestamp();
         attendanceStatus = "";
         registrationStatus = "";
         isRegistered = false;
+        firstTapToday = false;
+        journalSeq = TAP_JOURNAL_NO_SEQ;
+        fromQueue = false;
+        pushed = false;
         syncId = "";
+        rollupId = "";
         syncStartTime = 0;
         uploadRetries = 0;
     }
@@ -80,14 +98,40 @@ struct StateContext {
 static StateContext stateContext;
 
 // Timing
-static unsigned long lastWifiCheck = 0;
-static unsigned long lastIndicatorUpdate = 0;
 static unsigned long lastButtonCheck = 0;
 static unsigned long lastQueueSyncAttempt = 0;
+static unsigned long lastUserDbSave = 0;
 
-// Duplicate tap prevention
-static String lastTapUID = "";
-static unsigned long lastTapTime = 0;
+// Tap pipeline -> main loop handoff (decided taps waiting to be
+// uploaded, queued or reported)
+typedef enum {
+    TAP_ROUTE_UPLOAD,       // Registered, online
+    TAP_ROUTE_QUEUE,        // Registered, offline
+    TAP_ROUTE_PENDING       // Unregistered, online
+} TapRoute;
+
+typedef struct {
+    CardUid uid;
+    Timestamp time;
+    TapRoute route;
+    bool firstTapToday;
+    uint16_t journalSeq;
+} TapDecision;
+
+static QueueHandle_t tapDecisionQueue = nullptr;
+static TapDecision currentDecision;
+
+// Duplicate tap prevention (tap task only)
+static TapCooldown tapCooldown;
+
+// Crash-safe record of taps not yet in flash or Firebase
+static TapJournal tapJournal(rtc);
+
+#ifdef TAPTRACK_BENCH
+// Queue drain benchmark (bench build only)
+static unsigned long benchStartTime = 0;
+static int benchRecords = 0;
+#endif
 
 // =============================================================================
 // FORWARD DECLARATIONS
@@ -99,6 +143,14 @@ void handleIdle();
 void handleProcessCard();
 void handleUploadData();
 void handleQueueData();
+void startTapTask();
+void recoverTapJournal();
+void onWiFiLinkChange(bool connected);
+void applyModeToLink();
+void updateConnectivity();
+#ifdef TAPTRACK_BENCH
+void checkQueueBench();
+#endif
 
 // =============================================================================
 // STATE TRANSITION
@@ -107,39 +159,14 @@ void handleQueueData();
 void transitionTo(SystemState newState) {
     if (currentState == newState) return;
     
-    // State exit actions
-    switch (currentState) {
-        case STATE_PROCESS_CARD:
-            indicateProcessing(false);
-            break;
-        case STATE_UPLOAD_DATA:
-            indicateSyncing(false);
-            break;
-        default:
-            break;
-    }
-    
+    // No indicator entry/exit actions: tap feedback belongs to the tap
+    // task, and background uploads must not overwrite it
     previousState = currentState;
     currentState = newState;
     
     // Debug output
     const char* stateNames[] = {"INITIALIZE", "IDLE", "PROCESS_CARD", "UPLOAD_DATA", "QUEUE_DATA"};
     Serial.printf("[STATE] %s -> %s\n", stateNames[previousState], stateNames[currentState]);
-    
-    // State entry actions
-    switch (newState) {
-        case STATE_IDLE:
-            clearIndicators();
-            break;
-        case STATE_PROCESS_CARD:
-            indicateProcessing(true);
-            break;
-        case STATE_UPLOAD_DATA:
-            indicateSyncing(true);
-            break;
-        default:
-            break;
-    }
 }
 
 // =============================================================================
@@ -161,6 +188,7 @@ void checkModeButton() {
     }
     
     if (currentButtonState == LOW && lastButtonState == HIGH) {
+        notePowerActivity();
         modeButtonPressTime = millis();
         modeButtonPressed = true;
     }
@@ -202,16 +230,7 @@ void toggleMode() {
     saveSystemMode(currentMode);
     indicateMode(currentMode);
     beepSuccess();
-    
-    if (currentMode == MODE_FORCE_OFFLINE) {
-        isOnline = false;
-    } else if (currentMode == MODE_FORCE_ONLINE && isWiFiConnected()) {
-        isOnline = true;
-        if (!firebaseInitialized) {
-            initFirebase();
-            firebaseInitialized = true;
-        }
-    }
+    applyModeToLink();
 }
 
 // =============================================================================
@@ -228,6 +247,36 @@ bool isRTCValid(const DateTime& time) {
             time.second <= 59);
 }
 
+/**
+ * Queue journaled taps that never reached flash or Firebase
+ * A tap already in the queue (crash between enqueue and commit) is only
+ * committed, so recovery never duplicates a queued record.
+ */
+void recoverTapJournal() {
+#if TAP_JOURNAL
+    TapJournalEntry pending[TAP_JOURNAL_SLOTS];
+    uint8_t count = tapJournal.begin(pending);
+    
+    for (uint8_t i = 0; i < count; i++) {
+        const TapJournalEntry& entry = pending[i];
+        if (!attendanceQueue.contains(entry.uid, entry.time.epoch)) {
+            Serial.printf("[JOURNAL] Recovering tap %s @ %s\n",
+                         entry.uid.toString().c_str(), entry.time.toString().c_str());
+            if (!attendanceQueue.enqueue(entry.uid, userDB.getName(entry.uid), entry.time,
+                                         entry.late ? "late" : "present", "registered",
+                                         entry.firstTapToday)) {
+                continue;   // Queue full - keep it pending for the next boot
+            }
+        }
+        tapJournal.commit(entry.seq);
+    }
+    
+    if (count > 0) {
+        Serial.printf("[JOURNAL] %d unsaved taps recovered\n", count);
+    }
+#endif
+}
+
 String getAttendanceStatus(const DateTime& time) {
     if (time.hour < ON_TIME_HOUR) {
         return "present";
@@ -237,25 +286,18 @@ String getAttendanceStatus(const DateTime& time) {
     return "present";
 }
 
-String formatTimestamp(const DateTime& time) {
-    char buf[30];
-    snprintf(buf, sizeof(buf), "%04u-%02u-%02uT%02u:%02u:%02u.000Z",
-             time.year, time.month, time.day,
-             time.hour, time.minute, time.second);
-    return String(buf);
+uint32_t dayKey(const DateTime& time) {
+    return (uint32_t)time.year * 10000 + time.month * 100 + time.day;
 }
 
-bool isDuplicateTap(String uid) {
-    unsigned long now = millis();
+bool isDuplicateTap(const CardUid& uid) {
+    unsigned long remaining = tapCooldown.check(uid, millis());
     
-    if (lastTapUID == uid && (now - lastTapTime) < TAP_COOLDOWN_MS) {
-        Serial.printf("[WARN] Duplicate tap (wait %lu sec)\n", 
-                     (TAP_COOLDOWN_MS - (now - lastTapTime)) / 1000);
+    if (remaining > 0) {
+        Serial.printf("[WARN] Duplicate tap (wait %lu sec)\n", remaining / 1000);
         return true;
     }
     
-    lastTapUID = uid;
-    lastTapTime = now;
     return false;
 }
 
@@ -263,45 +305,58 @@ bool isDuplicateTap(String uid) {
 // CONNECTIVITY
 // =============================================================================
 
-bool checkAndReconnectWiFi() {
-    if (currentMode == MODE_FORCE_OFFLINE) {
-        isOnline = false;
-        return false;
+/**
+ * Wi-Fi link went up or down (from wifiLoop(), within a loop pass)
+ */
+void onWiFiLinkChange(bool connected) {
+    Serial.println(connected ? F("[WIFI] Connected") : F("[WIFI] Disconnected"));
+    setReachabilityLink(connected);
+    if (connected) {
+        startNtpSync();
     }
+    updateConnectivity();
+}
+
+/**
+ * Retry the link unless forced offline, and re-evaluate isOnline
+ */
+void applyModeToLink() {
+    setWiFiReconnect(currentMode != MODE_FORCE_OFFLINE);
+    updateConnectivity();
+}
+
+/**
+ * Online = mode allows it, link is up and the RTDB host answers
+ * Evaluated every loop pass from event-driven state (no radio access).
+ */
+void updateConnectivity() {
+    bool online = currentMode != MODE_FORCE_OFFLINE &&
+                  isWiFiConnected() && isHostReachable();
+    if (online == isOnline) return;
     
-    if (isWiFiConnected()) {
-        if (!isOnline) {
-            Serial.println(F("[WIFI] Reconnected"));
-            isOnline = true;
-            
-            if (!firebaseInitialized && currentMode != MODE_FORCE_OFFLINE) {
-                Serial.println(F("[FIREBASE] Reinitializing..."));
-                initFirebase();
-                firebaseInitialized = true;
-                
-                if (!isUserStreamActive()) {
-                    streamUsers();
-                }
-            }
-        }
-        return true;
-    } else {
-        if (isOnline) {
-            Serial.println(F("[WIFI] Disconnected"));
-            isOnline = false;
-        }
+    isOnline = online;
+    if (!online) {
+        Serial.println(F("[NET] Offline - queuing taps"));
+        return;
+    }
+    
+    Serial.println(F("[NET] Online"));
+    
+    if (!firebaseInitialized) {
+        Serial.println(F("[FIREBASE] Initializing..."));
+        initFirebase();
+        firebaseInitialized = true;
         
-        if (currentMode == MODE_FORCE_ONLINE) {
-            Serial.println(F("[WIFI] Attempting reconnection..."));
-            indicateConnecting(true);
-            bool connected = reconnectWiFi();
-            indicateConnecting(false);
-            isOnline = connected;
-            return connected;
+        if (!isUserStreamActive()) {
+            streamUsers();
         }
-        
-        return false;
+    } else {
+        // Old stream socket died with the link - resubscribe now
+        restartUserStream();
     }
+    
+    // Drain the offline queue now rather than at the next sync tick
+    lastQueueSyncAttempt = millis() - SYNC_INTERVAL_MS - 1;
 }
 
 // =============================================================================
@@ -366,6 +421,14 @@ void handleInitialize() {
     Serial.println(F("\n[WIFI] Initializing..."));
     bool wifiConnected = initWiFiManager();
     isOnline = wifiConnected && (currentMode != MODE_FORCE_OFFLINE);
+#ifdef TAPTRACK_BENCH
+    initReachability(BENCH_DATABASE_URL);
+#else
+    initReachability(FIREBASE_DATABASE_URL);
+#endif
+    setReachabilityLink(wifiConnected);
+    setWiFiLinkCallback(onWiFiLinkChange);
+    setWiFiReconnect(currentMode != MODE_FORCE_OFFLINE);
     
     if (isOnline) {
         Serial.println(F("[WIFI] Connected"));
@@ -386,20 +449,23 @@ void handleInitialize() {
     
     // Initialize RTC
     Serial.println(F("\n[RTC] Initializing..."));
+    rtc.begin();
+    initSoftClock();
+    DateTime now = getCurrentTime();
+    Serial.printf("[RTC] Time: %02d/%02d/%04d %02d:%02d:%02d\n",
+                 now.month, now.day, now.year,
+                 now.hour, now.minute, now.second);
+    if (!isRTCValid(now)) {
+        Serial.println(F("[RTC] Time may be invalid!"));
+    }
     if (isOnline) {
-        setupAndSyncRTC();
-    } else {
-        rtc.begin();
-        DateTime now = getCurrentTime();
-        Serial.printf("[RTC] Time: %02d/%02d/%04d %02d:%02d:%02d\n",
-                     now.month, now.day, now.year,
-                     now.hour, now.minute, now.second);
-        if (!isRTCValid(now)) {
-            Serial.println(F("[RTC] Time may be invalid!"));
-        }
+        startNtpSync();
     }
     Serial.println(F("[RTC] Ready"));
     
+    // Replay taps acknowledged but lost before they reached flash
+    recoverTapJournal();
+    
     // Initialize Firebase if online
     if (isOnline && currentMode != MODE_FORCE_OFFLINE) {
         Serial.println(F("\n[FIREBASE] Initializing..."));
@@ -436,8 +502,12 @@ void handleInitialize() {
     // Setup RFID interrupt
     gpio_pin_init_pullup(RFID_IRQ_PIN, GPIO_INPUT_MODE, GPIO_PULL_UP);
     enableInterrupt();
-    cardDetected = false;
+    initPower();
+    startTapTask();
+    startCardTask();
     attachInterrupt(digitalPinToInterrupt(RFID_IRQ_PIN), readCardISR, FALLING);
+    Serial.printf("[TASK] Network/storage loop on core %d, card + tap tasks on core %d\n",
+                 xPortGetCoreID(), TAP_TASK_CORE);
     
     // Show status
     userDB.printAllUsers();
@@ -465,26 +535,45 @@ void handleIdle() {
     unsigned long now = millis();
     
     // Background tasks
-    checkAndResetMFRC522();
-    
     if (now - lastButtonCheck > 50) {
         lastButtonCheck = now;
         checkModeButton();
     }
     
-    if (now - lastIndicatorUpdate > 50) {
-        lastIndicatorUpdate = now;
-        updateIndicator();
+    if (now - lastUserDbSave > USER_DB_SAVE_INTERVAL_MS) {
+        lastUserDbSave = now;
+        userDB.saveIfNeeded();
     }
     
-    if (currentMode != MODE_FORCE_OFFLINE && (now - lastWifiCheck > WIFI_CHECK_INTERVAL_MS)) {
-        lastWifiCheck = now;
-        checkAndReconnectWiFi();
-    }
+    latencyTraceCollect();
+    softClockLoop();
+    queueFull = attendanceQueue.isFull();
+    
+    // Light sleep only while the radio is unused; modem sleep between uploads
+    setLowPowerAllowed(WiFi.getMode() == WIFI_OFF ||
+                       (currentMode == MODE_FORCE_OFFLINE && !isWiFiConnected()));
+    setNetworkBusy(isUploadInFlight());
+    
+    // Link changes arrive as events; retries and probes never block
+    wifiLoop();
+    reachabilityLoop();
+    updateConnectivity();
     
     // Process Firebase events
     if (isOnline && firebaseInitialized) {
         app.loop();
+        maintainUserStream();
+        flushPendingUsers();
+    }
+    
+#ifdef TAPTRACK_BENCH
+    checkQueueBench();
+#endif
+    
+    // Taps decided by the tap task - record them before anything else
+    if (xQueueReceive(tapDecisionQueue, &currentDecision, 0) == pdTRUE) {
+        transitionTo(STATE_PROCESS_CARD);
+        return;
     }
     
     // Periodic queue sync (only if not currently processing a card)
@@ -499,135 +588,104 @@ void handleIdle() {
             stateContext.reset();
             stateContext.cardUID = record->uid;
             stateContext.userName = record->name;
-            stateContext.timestamp = record->timestamp;
+            stateContext.time = record->time;
             stateContext.attendanceStatus = record->attendanceStatus;
             stateContext.registrationStatus = record->registrationStatus;
+            stateContext.firstTapToday = record->firstTapToday;
+            stateContext.pushed = record->pushed;
+            stateContext.fromQueue = true;
             stateContext.isRegistered = true;
             
             Serial.println(F("[QUEUE] Processing queued record..."));
+            setNetworkBusy(true);
             transitionTo(STATE_UPLOAD_DATA);
             return;
         }
     }
-    
-    // Check for card detection
-    if (cardDetected) {
-        delay(50); // Card stabilization
-        transitionTo(STATE_PROCESS_CARD);
-        return;
-    }
-    
-    activateRec();
 }
 
 void handleProcessCard() {
-    // Read card UID
-    String uid = readCardUID();
-    
-    if (uid.length() == 0) {
-        Serial.println(F("[ERROR] Failed to read card. Try again."));
-        indicateError();
-        clearInt();
-        cardDetected = false;
-        transitionTo(STATE_IDLE);
-        return;
-    }
-    
-    // Get current time
-    DateTime time = getCurrentTime();
-    
-    // Validate RTC
-    if (!isRTCValid(time)) {
-        Serial.println(F("[ERROR] RTC time invalid!"));
-        indicateErrorRTC();
-        clearInt();
-        cardDetected = false;
-        transitionTo(STATE_IDLE);
-        return;
-    }
-    
-    // Check duplicate tap
-    if (isDuplicateTap(uid)) {
-        clearInt();
-        cardDetected = false;
-        transitionTo(STATE_IDLE);
-        return;
-    }
-    
-    // Populate state context
+    // Route a tap decided by the tap task (feedback was already given)
     stateContext.reset();
-    stateContext.cardUID = uid;
-    stateContext.timestamp = formatTimestamp(time);
-    stateContext.attendanceStatus = getAttendanceStatus(time);
-    
-    // Lookup user
-    UserInfo userInfo = userDB.getUserInfo(uid);
-    stateContext.userName = userInfo.name;
-    stateContext.isRegistered = userInfo.isRegistered;
-    stateContext.registrationStatus = userInfo.isRegistered ? "registered" : "unregistered";
-    
-    // Print info
-    Serial.println(F("\n========================================"));
-    Serial.printf("Card UID: %s\n", uid.c_str());
-    Serial.printf("Time: %02d/%02d/%04d %02d:%02d:%02d\n",
-                 time.month, time.day, time.year,
-                 time.hour, time.minute, time.second);
-    
-    if (stateContext.isRegistered) {
-        Serial.printf("User: %s (Registered)\n", stateContext.userName.c_str());
-        userDB.recordTap(uid);
-    } else {
-        Serial.println(F("User: Unknown (Unregistered)"));
-    }
-    Serial.println(F("========================================\n"));
-    
-    // Clear interrupt
-    clearInt();
-    cardDetected = false;
+    stateContext.cardUID = currentDecision.uid;
+    stateContext.userName = userDB.getName(currentDecision.uid);
+    stateContext.time = currentDecision.time;
+    stateContext.attendanceStatus = getAttendanceStatus(toDateTime(currentDecision.time));
+    stateContext.isRegistered = currentDecision.route != TAP_ROUTE_PENDING;
+    stateContext.registrationStatus = stateContext.isRegistered ? "registered" : "unregistered";
+    stateContext.firstTapToday = currentDecision.firstTapToday;
+    stateContext.journalSeq = currentDecision.journalSeq;
     
-    // Decide next state based on connectivity and registration
-    if (isOnline && currentMode != MODE_FORCE_OFFLINE) {
-        // ONLINE PATH
-        if (stateContext.isRegistered) {
+    switch (currentDecision.route) {
+        case TAP_ROUTE_UPLOAD:
+            setNetworkBusy(true);
             transitionTo(STATE_UPLOAD_DATA);
-        } else {
-            // Unregistered - send to pending users
-            Serial.println(F("[PENDING] Sending to pending users"));
-            sendPendingUser(uid, stateContext.timestamp);
-            fetchUserFromFirebase(uid);
-            indicateSuccessOnline();
-            transitionTo(STATE_IDLE);
-        }
-    } else {
-        // OFFLINE PATH
-        if (stateContext.isRegistered) {
+            break;
+            
+        case TAP_ROUTE_QUEUE:
             transitionTo(STATE_QUEUE_DATA);
-        } else {
-            Serial.println(F("[ERROR] Offline + Unregistered - Cannot process"));
-            indicateErrorUnregistered();
+            break;
+            
+        case TAP_ROUTE_PENDING:
+            Serial.println(F("[PENDING] Reporting to pending users"));
+            reportPendingUser(stateContext.cardUID, stateContext.time);
             transitionTo(STATE_IDLE);
-        }
+            break;
     }
 }
 
+static bool rollupOwed() {
+    return ATTENDANCE_DAY_ROLLUP && stateContext.firstTapToday;
+}
+
+/**
+ * Keep an unfinished upload for the next queue sync
+ * A queued record stays at the head (noting a landed push); a live tap
+ * is queued with whatever is still owed.
+ */
+static void deferUpload() {
+    if (!stateContext.fromQueue) {
+        transitionTo(STATE_QUEUE_DATA);
+        return;
+    }
+    
+    if (stateContext.pushed) {
+        attendanceQueue.markPushed();
+    }
+    transitionTo(STATE_IDLE);
+}
+
 void handleUploadData() {
     // Check if still online
     if (!isOnline || !isFirebaseReady()) {
         Serial.println(F("[WARN] Lost connection during upload"));
-        transitionTo(STATE_QUEUE_DATA);
+        deferUpload();
         return;
     }
     
-    // Attempt upload
-    stateContext.syncId = sendToFirebase(
-        stateContext.cardUID,
-        stateContext.userName,
-        stateContext.timestamp,
-        stateContext.attendanceStatus,
-        stateContext.registrationStatus
-    );
+    // Attempt upload; a record whose push already landed only owes the rollup
+    if (!stateContext.pushed) {
+        stateContext.syncId = sendToFirebase(
+            stateContext.cardUID,
+            stateContext.userName,
+            stateContext.time,
+            stateContext.attendanceStatus,
+            stateContext.registrationStatus
+        );
+    }
+    bool sent = stateContext.pushed || stateContext.syncId.length() > 0;
+    
+#if ATTENDANCE_DAY_ROLLUP
+    // Daily rollup - only a user's first tap of the day is written, so
+    // /attendanceByDay/<date> stays O(users) for dashboards. Create-only,
+    // so resending it with a retried record is harmless.
+    if (sent && rollupOwed()) {
+        stateContext.rollupId = sendDayRollup(stateContext.cardUID, stateContext.time,
+                                              stateContext.attendanceStatus);
+    }
+#endif
     
-    if (stateContext.syncId.length() > 0) {
+    if (sent) {
         // Upload initiated - wait for confirmation
         stateContext.syncStartTime = millis();
         
@@ -638,18 +696,31 @@ void handleUploadData() {
         while (waitCount < maxWait) {
             app.loop();
             
-            if (isSyncConfirmed(stateContext.syncId)) {
+            // Link events land while we wait - don't sit out the timeout
+            if (!isWiFiConnected()) {
+                Serial.println(F("[WARN] Link lost during upload"));
+                deferUpload();
+                return;
+            }
+            
+            if (!stateContext.pushed && isSyncConfirmed(stateContext.syncId)) {
                 Serial.println(F("[SYNC] Upload confirmed"));
+                stateContext.pushed = true;
+            }
+            if (rollupOwed() && isSyncConfirmed(stateContext.rollupId)) {
+                Serial.println(F("[SYNC] Day rollup confirmed"));
+                stateContext.firstTapToday = false;
+            }
+            
+            if (stateContext.pushed && !rollupOwed()) {
+                tapJournal.commit(stateContext.journalSeq);
                 
-                // If this was from the queue, remove it
-                if (!attendanceQueue.isEmpty()) {
-                    AttendanceRecord* record = attendanceQueue.peek();
-                    if (record && record->uid == stateContext.cardUID) {
-                        attendanceQueue.dequeueBySyncId(stateContext.syncId);
-                    }
+                // If this was from the queue, remove it (only this FSM
+                // takes records off the head)
+                if (stateContext.fromQueue) {
+                    attendanceQueue.dequeue();
                 }
                 
-                indicateSuccessOnline();
                 transitionTo(STATE_IDLE);
                 return;
             }
@@ -658,16 +729,18 @@ void handleUploadData() {
             waitCount++;
         }
         
-        // Timeout - queue it
+        // Timeout - keep what is still owed, and check the host is still there
         Serial.println(F("[WARN] Upload timeout"));
-        transitionTo(STATE_QUEUE_DATA);
+        requestReachabilityProbe();
+        deferUpload();
     } else {
         // Upload failed immediately
         Serial.println(F("[ERROR] Upload failed"));
+        requestReachabilityProbe();
         stateContext.uploadRetries++;
         
         if (stateContext.uploadRetries > 2) {
-            transitionTo(STATE_QUEUE_DATA);
+            deferUpload();
         } else {
             delay(500);
             // Retry
@@ -677,25 +750,246 @@ void handleUploadData() {
 
 void handleQueueData() {
     if (attendanceQueue.isFull()) {
+        // Filled up after the tap task checked - the record is lost
         Serial.println(F("[ERROR] Queue full! Cannot record attendance."));
         indicateErrorQueueFull();
+        queueFull = true;
         transitionTo(STATE_IDLE);
         return;
     }
     
     Serial.println(F("[QUEUE] Queuing locally"));
-    attendanceQueue.enqueue(
-        stateContext.cardUID,
-        stateContext.userName,
-        stateContext.timestamp,
-        stateContext.attendanceStatus,
-        stateContext.registrationStatus
-    );
-    
-    indicateSuccessOffline();
+    if (attendanceQueue.enqueue(
+            stateContext.cardUID,
+            stateContext.userName,
+            stateContext.time,
+            stateContext.attendanceStatus,
+            stateContext.registrationStatus,
+            stateContext.firstTapToday,
+            stateContext.pushed)) {
+        tapJournal.commit(stateContext.journalSeq);
+    }
+    queueFull = attendanceQueue.isFull();
+    
     transitionTo(STATE_IDLE);
 }
 
+// =============================================================================
+// TAP PIPELINE (tap task, APP core)
+// =============================================================================
+
+/**
+ * Decide what a tap means and give feedback right away
+ * Only the user cache, the RTC and volatile flags are touched here;
+ * uploads, flash writes and pending-user reports are handed to the main
+ * loop through tapDecisionQueue, so network or SPIFFS stalls never
+ * delay the beep.
+ */
+static void processTap(const CardTap& tap) {
+    const CardUid& uid = tap.uid;
+    latencyTraceBegin(tap.detectedAtUs, tap.readAtUs);
+    notePowerActivity();
+    
+    if (uid.isEmpty()) {
+        Serial.println(F("[ERROR] Failed to read card. Try again."));
+        latencyTraceMark(TRACE_INDICATOR);
+        indicateError();
+        return;
+    }
+    
+    // Get current time (RAM only; text is produced at the upload edge)
+    Timestamp now = getTimestamp();
+    DateTime time = toDateTime(now);
+    
+    // Validate RTC
+    if (!isRTCValid(time)) {
+        Serial.println(F("[ERROR] RTC time invalid!"));
+        latencyTraceMark(TRACE_INDICATOR);
+        indicateErrorRTC();
+        return;
+    }
+    
+    // Check duplicate tap
+    if (isDuplicateTap(uid)) {
+        latencyTraceCancel();
+        return;
+    }
+    
+    // Lookup user
+    UserInfo userInfo = userDB.getUserInfo(uid);
+    latencyTraceMark(TRACE_DB_LOOKUP);
+    
+    // Only producer, so a free slot now is still free at xQueueSend
+    if (uxQueueSpacesAvailable(tapDecisionQueue) == 0) {
+        Serial.println(F("[ERROR] Tap backlog full - main loop stalled"));
+        latencyTraceMark(TRACE_INDICATOR);
+        indicateError();
+        return;
+    }
+    
+    TapDecision decision;
+    decision.uid = uid;
+    decision.time = now;
+    decision.firstTapToday = false;
+    decision.journalSeq = TAP_JOURNAL_NO_SEQ;
+    
+    // Print info
+    char uidHex[CARD_UID_HEX_LEN];
+    uid.toHex(uidHex);
+    Serial.println(F("\n========================================"));
+    Serial.printf("Card UID: %s\n", uidHex);
+    Serial.printf("Time: %02d/%02d/%04d %02d:%02d:%02d\n",
+                 time.month, time.day, time.year,
+                 time.hour, time.minute, time.second);
+    
+    if (userInfo.isRegistered) {
+        Serial.printf("User: %s (Registered)\n", userInfo.name.c_str());
+    } else {
+        Serial.println(F("User: Unknown (Unregistered)"));
+    }
+    Serial.println(F("========================================\n"));
+    
+    // Decide based on connectivity and registration
+    bool online = isOnline && currentMode != MODE_FORCE_OFFLINE;
+    latencyTraceMark(TRACE_DECISION);
+    
+    if (!userInfo.isRegistered && !online) {
+        Serial.println(F("[ERROR] Offline + Unregistered - Cannot process"));
+        latencyTraceMark(TRACE_INDICATOR);
+        indicateErrorUnregistered();
+        return;
+    }
+    
+    if (userInfo.isRegistered && !online && queueFull) {
+        Serial.println(F("[ERROR] Queue full! Cannot record attendance."));
+        latencyTraceMark(TRACE_INDICATOR);
+        indicateErrorQueueFull();
+        return;
+    }
+    
+    if (userInfo.isRegistered) {
+        userDB.recordTap(uid);
+        decision.firstTapToday = userDB.markPresent(uid, dayKey(time));
+        if (!decision.firstTapToday) {
+            Serial.println(F("Already marked present today"));
+        }
+    }
+    
+    decision.route = !userInfo.isRegistered ? TAP_ROUTE_PENDING :
+                     online ? TAP_ROUTE_UPLOAD : TAP_ROUTE_QUEUE;
+    
+#if TAP_JOURNAL
+    // Durable before the beep: a reset from here on is replayed at boot
+    if (userInfo.isRegistered) {
+        decision.journalSeq = tapJournal.append(uid, now,
+                                                getAttendanceStatus(time) == "late",
+                                                decision.firstTapToday);
+    }
+#endif
+    xQueueSend(tapDecisionQueue, &decision, 0);
+    
+    latencyTraceMark(TRACE_INDICATOR);
+    if (decision.route == TAP_ROUTE_QUEUE) {
+        indicateSuccessOffline();
+    } else {
+        indicateSuccessOnline();
+    }
+}
+
+static void tapTask(void* param) {
+    CardTap tap;
+    
+    for (;;) {
+        // Indicator patterns run from their own timer
+        if (takeCardTap(tap, portMAX_DELAY)) {
+            processTap(tap);
+        }
+    }
+}
+
+void startTapTask() {
+    tapDecisionQueue = xQueueCreate(TAP_DECISION_QUEUE_LEN, sizeof(TapDecision));
+    xTaskCreatePinnedToCore(tapTask, "tap", TAP_TASK_STACK, nullptr,
+                            TAP_TASK_PRIORITY, nullptr, TAP_TASK_CORE);
+}
+
+// =============================================================================
+// BENCHMARK (TAPTRACK_BENCH builds only)
+// =============================================================================
+
+#ifdef TAPTRACK_BENCH
+void printBenchStats() {
+    SyncState sync = getSyncState();
+    StreamHealth stream = getStreamHealth();
+    
+    Serial.println(F("\n=== Bench Stats ==="));
+    Serial.printf("Confirmed: %d | Failed: %d\n", sync.successCount, sync.failCount);
+    Serial.printf("Confirm latency: last %lu ms, avg %lu ms, max %lu ms\n",
+                 sync.lastConfirmMs,
+                 sync.successCount ? sync.totalConfirmMs / sync.successCount : 0,
+                 sync.maxConfirmMs);
+    Serial.printf("Stream: resubscribes %d, stalls %d, last catch-up %lu ms\n",
+                 stream.resubscribeCount, stream.stallCount, stream.lastCatchupMs);
+    Serial.printf("Queue: %d/%d\n", attendanceQueue.size(), MAX_QUEUE_SIZE);
+    Serial.println(F("===================\n"));
+}
+
+/**
+ * Time DS1302 transfers and the pin reconfiguration they used to pay for
+ */
+void benchRTC() {
+    const int runs = 100;
+    unsigned long minUs = ULONG_MAX, maxUs = 0, totalUs = 0;
+    
+    for (int i = 0; i < runs; i++) {
+        unsigned long start = micros();
+        rtc.getDateTime();
+        unsigned long us = micros() - start;
+        totalUs += us;
+        if (us < minUs) minUs = us;
+        if (us > maxUs) maxUs = us;
+    }
+    
+    // Direction switch: gpio_config() vs one enable register write
+    float configUs, fastUs;
+    rtc.benchDirectionSwitch(runs, configUs, fastUs);
+    
+    Serial.println(F("\n=== DS1302 Bench ==="));
+    Serial.printf("Burst read (%d runs): min %lu us, avg %lu us, max %lu us\n",
+                 runs, minUs, totalUs / runs, maxUs);
+    Serial.printf("Pin direction switch: gpio_config %.2f us, register %.3f us\n",
+                 configUs, fastUs);
+    Serial.println(F("(each transfer used to make 6-7 gpio_config calls)"));
+    Serial.println(F("====================\n"));
+}
+
+void startQueueBench(int count) {
+    Timestamp time = getTimestamp();
+    
+    resetSyncCounters();
+    for (int i = 0; i < count && !attendanceQueue.isFull(); i++) {
+        uint8_t bytes[4] = {0xBE, (uint8_t)(i >> 16), (uint8_t)(i >> 8), (uint8_t)i};
+        attendanceQueue.enqueue(CardUid(bytes, sizeof(bytes)), "Bench", time, "present", "registered");
+    }
+    
+    benchRecords = attendanceQueue.size();
+    benchStartTime = millis();
+    lastQueueSyncAttempt = 0;
+    Serial.printf("[BENCH] Draining %d queued records\n", benchRecords);
+}
+
+void checkQueueBench() {
+    if (benchStartTime == 0 || !attendanceQueue.isEmpty()) return;
+    
+    unsigned long elapsed = millis() - benchStartTime;
+    Serial.printf("[BENCH] Drained %d records in %lu ms (%.2f records/s)\n",
+                 benchRecords, elapsed,
+                 elapsed ? benchRecords * 1000.0f / elapsed : 0.0f);
+    printBenchStats();
+    benchStartTime = 0;
+}
+#endif
+
 // =============================================================================
 // SERIAL COMMANDS
 // =============================================================================
@@ -708,6 +1002,7 @@ void processSerialCommand() {
     cmd.toLowerCase();
     
     Serial.printf("\n> %s\n", cmd.c_str());
+    notePowerActivity();
     
     if (cmd == "status") {
         const char* stateNames[] = {"INITIALIZE", "IDLE", "PROCESS_CARD", "UPLOAD_DATA", "QUEUE_DATA"};
@@ -717,27 +1012,80 @@ void processSerialCommand() {
                      currentMode == MODE_AUTO ? "AUTO" :
                      currentMode == MODE_FORCE_ONLINE ? "FORCE ONLINE" : "FORCE OFFLINE");
         Serial.printf("Online: %s\n", isOnline ? "Yes" : "No");
-        Serial.printf("WiFi: %s\n", isWiFiConnected() ? "Connected" : "Disconnected");
+        WiFiLinkStats link = getWiFiLinkStats();
+        const char* linkNames[] = {"Idle", "Connecting", "Connected", "Backoff"};
+        Serial.printf("WiFi: %s (attempts: %lu, connects: %lu, drops: %lu, timeouts: %lu, last reason: %u, backoff: %lu ms)\n",
+                     linkNames[link.state], link.attempts, link.connects, link.drops,
+                     link.timeouts, link.lastReason, link.backoffMs);
+        ReachabilityStats reach = getReachabilityStats();
+        Serial.printf("RTDB host: %s (probes: %lu, failed: %lu, changes: %lu, last probe: %lu ms)\n",
+                     reach.reachable ? "Reachable" : "Unreachable",
+                     reach.probes, reach.failures, reach.changes, reach.lastProbeMs);
+        Serial.printf("WiFi connect: last %lu ms (%s), time to online %lu ms, fast %lu/%lu\n",
+                     link.lastConnectMs, link.lastConnectFast ? "fast" : "full scan",
+                     link.lastOnlineMs, link.fastConnects, link.fastAttempts);
         Serial.printf("Firebase: %s\n", firebaseInitialized ? "Initialized" : "Not initialized");
-        Serial.printf("Stream: %s\n", isUserStreamActive() ? "Active" : "Inactive");
-        Serial.printf("Users: %d\n", userDB.getUserCount());
+        StreamHealth stream = getStreamHealth();
+        Serial.printf("Stream: %s (resubscribes: %d, stalls: %d, last catch-up: %lu ms)\n",
+                     stream.active ? "Active" : "Inactive",
+                     stream.resubscribeCount, stream.stallCount, stream.lastCatchupMs);
+        Serial.printf("Users: %d (present today: %d)\n", userDB.getUserCount(),
+                     userDB.countMarkedOn(dayKey(getCurrentTime())));
         Serial.printf("Queue: %d/%d\n", attendanceQueue.size(), MAX_QUEUE_SIZE);
+        TapCooldownStats cooldown = tapCooldown.getStats(millis());
+        Serial.printf("Cooldown: %d/%d UIDs (checks: %lu, duplicates: %lu, evictions: %lu)\n",
+                     cooldown.occupancy, TAP_COOLDOWN_SLOTS,
+                     cooldown.checks, cooldown.duplicates, cooldown.evictions);
+        TapJournalStats journal = tapJournal.getStats();
+        Serial.printf("Journal: seq %u (appends: %lu, commits: %lu, recovered: %lu, dropped: %lu, overruns: %lu, skipped: %lu, write last %lu us, max %lu us)\n",
+                     journal.seq, journal.appends, journal.commits, journal.recovered,
+                     journal.dropped, journal.overruns, journal.skipped,
+                     journal.lastWriteUs, journal.maxWriteUs);
+        RFIDStats rfid = getRFIDStats();
+        Serial.printf("RFID: %s (probes: %lu, failed: %lu, reinits: %lu, blind: %lu ms)\n",
+                     isRFIDHealthy() ? "OK" : "Not responding",
+                     rfid.probeCount, rfid.probeFailCount,
+                     rfid.reinitCount, rfid.blindTimeMs);
+        Serial.printf("RFID SPI @ %lu kHz: tap read last %lu us, avg %lu us, max %lu us | poll %lu us\n",
+                     (unsigned long)(MFRC522_SPICLOCK / 1000),
+                     rfid.lastTapReadUs,
+                     rfid.tapReadCount ? (uint32_t)(rfid.totalTapReadUs / rfid.tapReadCount) : 0,
+                     rfid.maxTapReadUs, rfid.lastPollUs);
+        SoftClockStats clock = getSoftClockStats();
+        Serial.printf("Clock: %s reference, drift %.1f ppm, NTP syncs %lu (last %lu s ago)\n",
+                     clock.ntpFresh ? "NTP" : "DS1302", clock.clockDriftPpm,
+                     clock.ntpSyncCount,
+                     clock.ntpSyncCount ? (millis() - clock.lastNtpMs) / 1000 : 0);
+        Serial.printf("DS1302: offset %ld us (max %lu), drift %.1f ppm (%lu samples), read %lu us\n",
+                     clock.lastOffsetUs, clock.maxOffsetUs, clock.driftPpm,
+                     clock.driftSamples, clock.lastReadUs);
+        Serial.printf("DS1302 writes: %lu (verified %lu, last landed %+ld us)\n",
+                     clock.rtcWrites, clock.rtcWritesVerified, clock.lastWriteOffsetUs);
+        if (clock.syncCount > 0) {
+            Serial.printf("DS1302 edges: %lu (timeouts %lu), last %lu s ago\n",
+                         clock.syncCount, clock.edgeTimeouts,
+                         (millis() - clock.lastSyncMs) / 1000);
+        } else {
+            Serial.printf("DS1302 edges: none caught (timeouts %lu)\n", clock.edgeTimeouts);
+        }
         Serial.println(F("=====================\n"));
     }
     else if (cmd == "mode auto") {
         currentMode = MODE_AUTO;
         saveSystemMode(currentMode);
+        applyModeToLink();
         Serial.println(F("Mode set to AUTO"));
     }
     else if (cmd == "mode online") {
         currentMode = MODE_FORCE_ONLINE;
         saveSystemMode(currentMode);
+        applyModeToLink();
         Serial.println(F("Mode set to FORCE ONLINE"));
     }
     else if (cmd == "mode offline") {
         currentMode = MODE_FORCE_OFFLINE;
         saveSystemMode(currentMode);
-        isOnline = false;
+        applyModeToLink();
         Serial.println(F("Mode set to FORCE OFFLINE"));
     }
     else if (cmd == "users") {
@@ -773,6 +1121,57 @@ void processSerialCommand() {
     else if (cmd == "test") {
         testIndicators();
     }
+    else if (cmd == "latency") {
+        printLatencyStats();
+    }
+    else if (cmd == "latency reset") {
+        resetLatencyStats();
+        Serial.println(F("Latency stats cleared"));
+    }
+    else if (cmd == "time") {
+        Timestamp now = getTimestamp();
+        SoftClockStats clock = getSoftClockStats();
+        NtpSample history[NTP_HISTORY_LEN];
+        uint8_t count = getNtpHistory(history, NTP_HISTORY_LEN);
+        int64_t nowUs = esp_timer_get_time();
+        
+        Serial.println(F("\n=== Time ==="));
+        Serial.printf("Local: %s (%s reference)\n", now.toString().c_str(),
+                     clock.ntpFresh ? "NTP" : "DS1302");
+        if (clock.driftSamples > 0) {
+            Serial.printf("Clock drift: %.1f ppm | DS1302 drift: %.1f ppm (%.2f s/day, %lu samples)\n",
+                         clock.clockDriftPpm, clock.driftPpm, clock.driftPpm * 0.0864f,
+                         clock.driftSamples);
+        } else {
+            Serial.printf("Clock drift: %.1f ppm | DS1302 drift: not measured yet\n",
+                         clock.clockDriftPpm);
+        }
+        Serial.printf("NTP offsets (%d):\n", count);
+        for (uint8_t i = 0; i < count; i++) {
+            Serial.printf("  %6lu s ago: %+.3f ms\n",
+                         (unsigned long)((nowUs - history[i].atUs) / 1000000),
+                         history[i].offsetUs / 1000.0f);
+        }
+        Serial.println(F("============\n"));
+    }
+    else if (cmd == "power") {
+        printPowerStats();
+    }
+    else if (cmd == "power reset") {
+        resetPowerStats();
+        Serial.println(F("Power stats cleared"));
+    }
+#ifdef TAPTRACK_BENCH
+    else if (cmd == "bench") {
+        printBenchStats();
+    }
+    else if (cmd == "bench rtc") {
+        benchRTC();
+    }
+    else if (cmd.startsWith("bench ")) {
+        startQueueBench(cmd.substring(6).toInt());
+    }
+#endif
     else if (cmd == "help") {
         Serial.println(F("\n=== Commands ==="));
         Serial.println(F("status      - Show system status"));
@@ -787,6 +1186,16 @@ void processSerialCommand() {
         Serial.println(F("fetch users - Fetch users from Firebase"));
         Serial.println(F("restart     - Restart device"));
         Serial.println(F("test        - Test indicators"));
+        Serial.println(F("latency     - Tap-to-feedback p50/p95/p99"));
+        Serial.println(F("latency reset - Clear latency stats"));
+        Serial.println(F("time        - Clock source, drift and NTP offsets"));
+        Serial.println(F("power       - Sleep residency and wake latency"));
+        Serial.println(F("power reset - Clear power stats"));
+#ifdef TAPTRACK_BENCH
+        Serial.println(F("bench <n>   - Queue n records and time the drain"));
+        Serial.println(F("bench       - Show sync/stream bench stats"));
+        Serial.println(F("bench rtc   - Time DS1302 transfers"));
+#endif
         Serial.println(F("================\n"));
     }
     else {
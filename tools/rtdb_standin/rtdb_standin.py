@@ -0,0 +1,482 @@
+#!/usr/bin/env python3
+"""
+TapTrack - Firebase RTDB stand-in server
+
+Minimal Realtime Database compatible REST + SSE server for benchmarking
+the device sync path without a real Firebase project.
+
+Supported:
+  GET    /<path>.json            read (or SSE stream with Accept: text/event-stream)
+  PUT    /<path>.json            set
+  POST   /<path>.json            push (returns {"name": "<key>"})
+  PATCH  /<path>.json            multi-path update (keys may contain '/')
+  DELETE /<path>.json            remove
+  GET    /.stats                 request counters and latency summary
+  POST   /.reset                 clear stats (data is kept)
+
+Fault injection: fixed/jittered latency, HTTP 503 error rate, dropped
+connections, and periodic SSE disconnects. Optional user churn mutates
+/users in the background to exercise stream catch-up.
+
+Usage:
+  python3 rtdb_standin.py --port 443 --latency-ms 80 --error-rate 0.05
+"""
+
+import argparse
+import json
+import os
+import random
+import socketserver
+import ssl
+import string
+import subprocess
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, HTTPServer
+from urllib.parse import urlsplit, parse_qs
+
+# =============================================================================
+# DATA TREE
+# =============================================================================
+
+
+class Tree:
+    """JSON tree with RTDB path semantics and change listeners."""
+
+    def __init__(self):
+        self.root = {}
+        self.lock = threading.Lock()
+        self.listeners = []  # (path, queue-like callback)
+
+    @staticmethod
+    def split(path):
+        return [p for p in path.strip("/").split("/") if p]
+
+    def get(self, path):
+        with self.lock:
+            node = self.root
+            for key in self.split(path):
+                if not isinstance(node, dict) or key not in node:
+                    return None
+                node = node[key]
+            return json.loads(json.dumps(node))
+
+    def _set_locked(self, path, value):
+        keys = self.split(path)
+        if not keys:
+            self.root = value if isinstance(value, dict) else {}
+            return
+        node = self.root
+        for key in keys[:-1]:
+            if not isinstance(node.get(key), dict):
+                node[key] = {}
+            node = node[key]
+        if value is None:
+            node.pop(keys[-1], None)
+        else:
+            node[keys[-1]] = value
+
+    def set(self, path, value):
+        with self.lock:
+            self._set_locked(path, value)
+        self.notify("put", path, value)
+
+    def update(self, path, changes):
+        with self.lock:
+            for key, value in changes.items():
+                self._set_locked(path.rstrip("/") + "/" + key, value)
+        self.notify("patch", path, changes)
+
+    def push(self, path, value):
+        key = push_id()
+        self.set(path.rstrip("/") + "/" + key, value)
+        return key
+
+    # -------------------------------------------------------------------------
+
+    def subscribe(self, path, callback):
+        with self.lock:
+            self.listeners.append((path, callback))
+
+    def unsubscribe(self, callback):
+        with self.lock:
+            self.listeners = [l for l in self.listeners if l[1] is not callback]
+
+    def notify(self, event, path, data):
+        with self.lock:
+            listeners = list(self.listeners)
+        norm = "/" + "/".join(self.split(path))
+        for base, callback in listeners:
+            base = "/" + "/".join(self.split(base))
+            if base == "/":
+                rel = norm
+            elif norm == base or norm.startswith(base + "/"):
+                rel = norm[len(base):] or "/"
+            else:
+                continue
+            callback(event, rel, data)
+
+
+_PUSH_CHARS = "-" + string.digits + string.ascii_uppercase + "_" + string.ascii_lowercase
+_last_push = [0, 0]
+
+
+def push_id():
+    """Chronologically ordered key in the same shape as RTDB push IDs."""
+    now = int(time.time() * 1000)
+    if now == _last_push[0]:
+        _last_push[1] += 1
+    else:
+        _last_push[:] = [now, 0]
+    head = ""
+    for _ in range(8):
+        head = _PUSH_CHARS[now % 64] + head
+        now //= 64
+    return head + "".join(random.choice(_PUSH_CHARS) for _ in range(8)) + "%04d" % (_last_push[1] % 10000)
+
+
+# Paths the project's rules make create-only (".write": "!data.exists()")
+CREATE_ONLY = [["attendanceByDay", "*", "*"]]
+
+
+def is_create_only(path):
+    keys = Tree.split(path)
+    for rule in CREATE_ONLY:
+        if len(keys) == len(rule) and all(r in ("*", k) for r, k in zip(rule, keys)):
+            return True
+    return False
+
+
+# =============================================================================
+# STATS
+# =============================================================================
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        with getattr(self, "lock", threading.Lock()):
+            self.started = time.time()
+            self.counts = {}
+            self.bytes_in = 0
+            self.faults = {"error": 0, "drop": 0, "sse_drop": 0}
+            self.service_ms = []
+
+    def record(self, method, nbytes, service_ms):
+        with self.lock:
+            self.counts[method] = self.counts.get(method, 0) + 1
+            self.bytes_in += nbytes
+            self.service_ms.append(service_ms)
+            if len(self.service_ms) > 10000:
+                self.service_ms = self.service_ms[-5000:]
+
+    def fault(self, kind):
+        with self.lock:
+            self.faults[kind] += 1
+
+    def snapshot(self):
+        with self.lock:
+            lat = sorted(self.service_ms)
+
+            def pct(p):
+                return round(lat[min(len(lat) - 1, int(len(lat) * p))], 1) if lat else None
+
+            elapsed = time.time() - self.started
+            writes = sum(self.counts.get(m, 0) for m in ("PUT", "POST", "PATCH", "DELETE"))
+            return {
+                "uptime_s": round(elapsed, 1),
+                "requests": dict(self.counts),
+                "writes_per_s": round(writes / elapsed, 2) if elapsed > 0 else 0,
+                "bytes_in": self.bytes_in,
+                "avg_write_bytes": round(self.bytes_in / writes, 1) if writes else 0,
+                "faults": dict(self.faults),
+                "service_ms": {"p50": pct(0.50), "p95": pct(0.95), "p99": pct(0.99)},
+            }
+
+
+# =============================================================================
+# HTTP HANDLER
+# =============================================================================
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "rtdb-standin/1.0"
+    # Headers and body go out as separate writes; with Nagle on, the body
+    # waits for the client's delayed ACK (~40 ms on every response)
+    disable_nagle_algorithm = True
+
+    # Set in main()
+    tree = None
+    stats = None
+    opts = None
+
+    def log_message(self, fmt, *args):
+        if self.opts.verbose:
+            sys.stderr.write("%s %s\n" % (self.address_string(), fmt % args))
+
+    # -------------------------------------------------------------------------
+
+    def _path(self):
+        url = urlsplit(self.path)
+        path = url.path
+        if path.endswith(".json"):
+            path = path[:-5]
+        return path or "/", parse_qs(url.query)
+
+    def _body(self):
+        length = int(self.headers.get("Content-Length") or 0)
+        raw = self.rfile.read(length) if length else b""
+        return raw, (json.loads(raw) if raw else None)
+
+    def _send(self, code, payload, silent=False):
+        body = b"" if silent else json.dumps(payload, separators=(",", ":")).encode()
+        self.send_response(204 if silent and code == 200 else code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def _inject_faults(self):
+        """Apply latency and fault injection. Returns False if request was dropped."""
+        o = self.opts
+        delay = o.latency_ms + (random.uniform(0, o.jitter_ms) if o.jitter_ms else 0)
+        if delay > 0:
+            time.sleep(delay / 1000.0)
+        if o.drop_rate and random.random() < o.drop_rate:
+            self.stats.fault("drop")
+            self.close_connection = True
+            try:
+                self.connection.shutdown(2)
+            except OSError:
+                pass
+            return False
+        if o.error_rate and random.random() < o.error_rate:
+            self.stats.fault("error")
+            self._send(503, {"error": "Service Unavailable (injected)"})
+            return False
+        return True
+
+    def _handle(self, method):
+        t0 = time.monotonic()
+        path, query = self._path()
+
+        if path == "/.stats":
+            return self._send(200, self.stats.snapshot())
+        if path == "/.reset":
+            self.stats.reset()
+            return self._send(200, {"ok": True})
+
+        raw, body = self._body() if method in ("PUT", "POST", "PATCH") else (b"", None)
+
+        if method == "GET" and "text/event-stream" in (self.headers.get("Accept") or ""):
+            return self._stream(path)
+
+        if not self._inject_faults():
+            return
+
+        silent = query.get("print", [""])[0] == "silent"
+        if method == "GET":
+            result = self.tree.get(path)
+        elif method == "PUT":
+            if is_create_only(path) and self.tree.get(path) is not None:
+                return self._send(401, {"error": "Permission denied"})
+            self.tree.set(path, body)
+            result = body
+        elif method == "POST":
+            result = {"name": self.tree.push(path, body)}
+        elif method == "PATCH":
+            if not isinstance(body, dict):
+                return self._send(400, {"error": "PATCH body must be an object"})
+            self.tree.update(path, body)
+            result = body
+        elif method == "DELETE":
+            self.tree.set(path, None)
+            result = None
+        else:
+            return self._send(405, {"error": "method not allowed"})
+
+        self._send(200, result, silent)
+        self.stats.record(method, len(raw), (time.monotonic() - t0) * 1000.0)
+
+    # -------------------------------------------------------------------------
+
+    def _stream(self, path):
+        """Server-sent events in the RTDB wire format."""
+        self.stats.record("STREAM", 0, 0)
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Cache-Control", "no-cache")
+        self.send_header("Connection", "keep-alive")
+        self.end_headers()
+
+        events = []
+        cond = threading.Condition()
+
+        def on_change(event, rel, data):
+            with cond:
+                events.append((event, rel, data))
+                cond.notify()
+
+        def emit(event, data):
+            msg = "event: %s\ndata: %s\n\n" % (event, json.dumps(data, separators=(",", ":")))
+            self.wfile.write(msg.encode())
+            self.wfile.flush()
+
+        self.tree.subscribe(path, on_change)
+        o = self.opts
+        drop_at = time.time() + o.sse_drop_after if o.sse_drop_after else None
+        last_write = time.time()
+        try:
+            time.sleep(o.latency_ms / 1000.0)
+            emit("put", {"path": "/", "data": self.tree.get(path)})
+            while True:
+                with cond:
+                    cond.wait(timeout=1.0)
+                    pending, events[:] = list(events), []
+                for event, rel, data in pending:
+                    emit(event, {"path": rel, "data": data})
+                    last_write = time.time()
+                now = time.time()
+                if now - last_write >= o.keepalive_s:
+                    emit("keep-alive", None)
+                    last_write = now
+                if drop_at and now >= drop_at:
+                    # Silent stall: stop writing but keep the socket open
+                    self.stats.fault("sse_drop")
+                    if o.sse_stall:
+                        time.sleep(o.sse_stall)
+                    break
+        except (BrokenPipeError, ConnectionResetError, ssl.SSLError, OSError):
+            pass
+        finally:
+            self.tree.unsubscribe(on_change)
+            self.close_connection = True
+
+    def do_GET(self):
+        self._handle("GET")
+
+    def do_PUT(self):
+        self._handle("PUT")
+
+    def do_POST(self):
+        self._handle("POST")
+
+    def do_PATCH(self):
+        self._handle("PATCH")
+
+    def do_DELETE(self):
+        self._handle("DELETE")
+
+
+class Server(socketserver.ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+
+# =============================================================================
+# BACKGROUND USER CHURN
+# =============================================================================
+
+
+def random_uid():
+    return "".join(random.choice("0123456789ABCDEF") for _ in range(8))
+
+
+def seed_users(tree, count):
+    for i in range(count):
+        uid = random_uid()
+        tree.set("/users/" + uid, {"uid": uid, "name": "Student %03d" % (i + 1), "status": "registered"})
+
+
+def churn_users(tree, interval):
+    """Periodically add, rename or delete a user so streams have work to catch up on."""
+    n = 0
+    while True:
+        time.sleep(interval)
+        users = tree.get("/users") or {}
+        action = random.choice(["add", "rename", "delete"] if users else ["add"])
+        n += 1
+        if action == "add":
+            uid = random_uid()
+            tree.set("/users/" + uid, {"uid": uid, "name": "Churn %04d" % n, "status": "registered"})
+        elif action == "rename":
+            uid = random.choice(list(users))
+            tree.set("/users/%s/name" % uid, "Renamed %04d" % n)
+        else:
+            tree.set("/users/" + random.choice(list(users)), None)
+
+
+# =============================================================================
+# MAIN
+# =============================================================================
+
+
+def ensure_cert(cert, key):
+    if os.path.exists(cert) and os.path.exists(key):
+        return
+    print("Generating self-signed certificate (%s, %s)" % (cert, key))
+    subprocess.check_call([
+        "openssl", "req", "-x509", "-newkey", "rsa:2048", "-nodes", "-days", "365",
+        "-subj", "/CN=rtdb-standin", "-keyout", key, "-out", cert,
+    ], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=443)
+    ap.add_argument("--plain", action="store_true", help="serve plain HTTP (for curl/host tools)")
+    ap.add_argument("--cert", default=os.path.join(here, "standin-cert.pem"))
+    ap.add_argument("--key", default=os.path.join(here, "standin-key.pem"))
+    ap.add_argument("--latency-ms", type=float, default=0, help="fixed delay per request")
+    ap.add_argument("--jitter-ms", type=float, default=0, help="extra uniform random delay")
+    ap.add_argument("--error-rate", type=float, default=0, help="fraction of requests answered 503")
+    ap.add_argument("--drop-rate", type=float, default=0, help="fraction of requests closed without reply")
+    ap.add_argument("--keepalive-s", type=float, default=30, help="SSE keep-alive period")
+    ap.add_argument("--sse-drop-after", type=float, default=0, help="end each SSE stream after N seconds")
+    ap.add_argument("--sse-stall", type=float, default=0, help="hold the dead stream open N seconds first")
+    ap.add_argument("--seed-users", type=int, default=0, help="populate /users with N users")
+    ap.add_argument("--churn-interval", type=float, default=0, help="mutate /users every N seconds")
+    ap.add_argument("--data", help="JSON file to load as the initial tree")
+    ap.add_argument("-v", "--verbose", action="store_true")
+    opts = ap.parse_args()
+
+    tree = Tree()
+    if opts.data:
+        with open(opts.data) as f:
+            tree.set("/", json.load(f))
+    if opts.seed_users:
+        seed_users(tree, opts.seed_users)
+    if opts.churn_interval:
+        threading.Thread(target=churn_users, args=(tree, opts.churn_interval), daemon=True).start()
+
+    Handler.tree = tree
+    Handler.stats = Stats()
+    Handler.opts = opts
+
+    httpd = Server((opts.host, opts.port), Handler)
+    scheme = "http"
+    if not opts.plain:
+        ensure_cert(opts.cert, opts.key)
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        ctx.load_cert_chain(opts.cert, opts.key)
+        httpd.socket = ctx.wrap_socket(httpd.socket, server_side=True)
+        scheme = "https"
+
+    print("RTDB stand-in on %s://%s:%d (latency %.0f+%.0f ms, errors %.0f%%, drops %.0f%%)" % (
+        scheme, opts.host, opts.port, opts.latency_ms, opts.jitter_ms,
+        opts.error_rate * 100, opts.drop_rate * 100))
+    try:
+        httpd.serve_forever()
+    except KeyboardInterrupt:
+        print(json.dumps(Handler.stats.snapshot(), indent=2))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+"""
+TapTrack - host sync driver for the RTDB stand-in
+
+Replays the device's upload protocol against rtdb_standin.py from a plain
+Linux box: queued records drained head-first, an /attendance push per
+record (schema 1 or 2), a create-only /attendanceByDay rollup for a
+user's first tap of the day, "Permission denied" on the rollup counted as
+already recorded, and a record kept at the head with its push noted
+until both have landed. Optionally watches the /users stream the way the
+supervisor does (resubscribe on a drop or stall, count catch-up time).
+
+This mirrors the wire protocol, not the firmware: Firebase.cpp itself
+only runs on an ESP32 (see the bench build in README.md). What it does
+catch is a change to the stand-in, the schema or the rollup rules that
+would make the device lose, duplicate or mis-roll records.
+
+Usage:
+  python3 rtdb_standin.py --plain --port 8080 --error-rate 0.1 --drop-rate 0.05 &
+  python3 sync_drive.py --url http://127.0.0.1:8080 --records 500 --check
+"""
+
+import argparse
+import http.client
+import json
+import random
+import ssl
+import sys
+import threading
+import time
+from urllib.parse import urlsplit
+
+# Mirrors of config.h / Firebase.h
+ATTENDANCE_CODE_PRESENT = 0
+ATTENDANCE_CODE_LATE = 1
+REGISTRATION_CODE_REGISTERED = 0
+ON_TIME_HOUR = 9
+
+# =============================================================================
+# REST CLIENT
+# =============================================================================
+
+
+class Rtdb:
+    """One keep-alive connection, reopened after any transport error."""
+
+    def __init__(self, url, timeout):
+        parts = urlsplit(url)
+        self.https = parts.scheme == "https"
+        self.host = parts.hostname
+        self.port = parts.port or (443 if self.https else 80)
+        self.timeout = timeout
+        self.conn = None
+
+    def connect(self):
+        if self.https:
+            ctx = ssl._create_unverified_context()   # stand-in cert is self-signed
+            return http.client.HTTPSConnection(self.host, self.port, timeout=self.timeout, context=ctx)
+        return http.client.HTTPConnection(self.host, self.port, timeout=self.timeout)
+
+    def request(self, method, path, body=None):
+        """Returns (status, payload); status 0 = transport failure."""
+        if self.conn is None:
+            self.conn = self.connect()
+        # bytes, so http.client sends it with the headers (no delayed-ACK stall)
+        data = json.dumps(body, separators=(",", ":")).encode() if body is not None else None
+        try:
+            self.conn.request(method, path + ".json", body=data,
+                              headers={"Content-Type": "application/json"})
+            resp = self.conn.getresponse()
+            raw = resp.read()
+            return resp.status, (json.loads(raw) if raw else None)
+        except (OSError, http.client.HTTPException, ValueError):
+            self.conn.close()
+            self.conn = None
+            return 0, None
+
+    def read(self, path, attempts=20):
+        """GET through injected faults."""
+        for _ in range(attempts):
+            status, body = self.request("GET", path)
+            if status == 200:
+                return body
+        raise RuntimeError("GET %s kept failing" % path)
+
+
+# =============================================================================
+# DEVICE UPLOAD PROTOCOL
+# =============================================================================
+
+
+def iso(epoch, offset_h):
+    t = time.gmtime(epoch + offset_h * 3600)
+    return time.strftime("%Y-%m-%dT%H:%M:%S", t) + "%+03d:00" % offset_h
+
+
+def local_date(epoch, offset_h):
+    return time.strftime("%Y-%m-%d", time.gmtime(epoch + offset_h * 3600))
+
+
+def late(epoch, offset_h):
+    return time.gmtime(epoch + offset_h * 3600).tm_hour >= ON_TIME_HOUR
+
+
+def push_payload(rec, opts):
+    if opts.schema >= 2:
+        return {"v": opts.schema, "u": rec["uid"], "t": rec["epoch"],
+                "a": ATTENDANCE_CODE_LATE if rec["late"] else ATTENDANCE_CODE_PRESENT,
+                "r": REGISTRATION_CODE_REGISTERED}
+    return {"uid": rec["uid"], "name": "Student " + rec["uid"],
+            "timestamp": iso(rec["epoch"], opts.utc_offset),
+            "attendanceStatus": "late" if rec["late"] else "present",
+            "registrationStatus": "registered"}
+
+
+def rollup_payload(rec, opts):
+    if opts.schema >= 2:
+        return {"t": rec["epoch"], "a": ATTENDANCE_CODE_LATE if rec["late"] else ATTENDANCE_CODE_PRESENT}
+    return {"timestamp": iso(rec["epoch"], opts.utc_offset),
+            "attendanceStatus": "late" if rec["late"] else "present"}
+
+
+def make_queue(opts):
+    """Synthetic taps, one per opts.gap_s, spread over opts.users cards."""
+    uids = ["%08X" % random.getrandbits(32) for _ in range(opts.users)]
+    seen = set()
+    queue = []
+    start = int(time.time())
+    for i in range(opts.records):
+        uid = random.choice(uids)
+        epoch = start + i * opts.gap_s
+        day = (uid, local_date(epoch, opts.utc_offset))
+        queue.append({"uid": uid, "epoch": epoch, "late": late(epoch, opts.utc_offset),
+                      "first": day not in seen, "pushed": False})
+        seen.add(day)
+    return queue
+
+
+def drain(db, queue, opts, stats):
+    """Upload head-first until empty; a failure leaves the record at the head."""
+    while queue:
+        rec = queue[0]
+        if not rec["pushed"]:
+            t0 = time.monotonic()
+            status, _ = db.request("POST", "/attendance", push_payload(rec, opts))
+            if status != 200:
+                stats["push_failures"] += 1
+                time.sleep(opts.retry_s)
+                continue
+            stats["push_ms"].append((time.monotonic() - t0) * 1000.0)
+            rec["pushed"] = True
+
+        if rec["first"]:
+            path = "/attendanceByDay/%s/%s" % (local_date(rec["epoch"], opts.utc_offset), rec["uid"])
+            status, body = db.request("PUT", path, rollup_payload(rec, opts))
+            denied = isinstance(body, dict) and "Permission denied" in str(body.get("error"))
+            if status != 200 and not denied:
+                stats["rollup_failures"] += 1
+                time.sleep(opts.retry_s)
+                continue
+            if denied:
+                stats["rollup_denied"] += 1
+
+        queue.pop(0)
+        stats["drained"] += 1
+
+
+# =============================================================================
+# STREAM WATCHER
+# =============================================================================
+
+
+def watch_stream(url, opts, stats, stop):
+    """Resubscribe to /users like the supervisor; time each snapshot."""
+    db = Rtdb(url, opts.stall_s)
+    while not stop.is_set():
+        t0 = time.monotonic()
+        conn = db.connect()
+        try:
+            conn.request("GET", "/users.json", headers={"Accept": "text/event-stream"})
+            resp = conn.getresponse()
+            stats["subscribes"] += 1
+            got_snapshot = False
+            while not stop.is_set():
+                line = resp.fp.readline()
+                if not line:
+                    break
+                if line.startswith(b"event: put") and not got_snapshot:
+                    got_snapshot = True
+                    stats["catchup_ms"].append((time.monotonic() - t0) * 1000.0)
+                elif line.startswith(b"event: put") or line.startswith(b"event: patch"):
+                    stats["stream_events"] += 1
+        except (OSError, http.client.HTTPException):
+            pass                        # Stall (socket timeout) or drop
+        finally:
+            conn.close()
+        if not stop.is_set():
+            time.sleep(opts.retry_s)
+
+
+# =============================================================================
+# CHECKS
+# =============================================================================
+
+
+def check(db, opts, expected):
+    """Every record pushed exactly once; every user-day rolled up with its first tap."""
+    errors = []
+    # Earlier runs share the tree; their cards are random, so filter on ours
+    ours = set(r["uid"] for r in expected)
+    key = "u" if opts.schema >= 2 else "uid"
+    pushed = [p for p in (db.read("/attendance") or {}).values()
+              if isinstance(p, dict) and p.get(key) in ours]
+    if len(pushed) != len(expected):
+        errors.append("attendance: %d records, expected %d" % (len(pushed), len(expected)))
+
+    days = db.read("/attendanceByDay") or {}
+    for rec in expected:
+        if not rec["first"]:
+            continue
+        entry = days.get(local_date(rec["epoch"], opts.utc_offset), {}).get(rec["uid"])
+        if entry != rollup_payload(rec, opts):
+            errors.append("rollup %s: %r" % (rec["uid"], entry))
+
+    uids = sorted(p[key] for p in pushed)
+    if uids != sorted(r["uid"] for r in expected):
+        errors.append("attendance: pushed UIDs differ from the queue")
+    return errors
+
+
+# =============================================================================
+# MAIN
+# =============================================================================
+
+
+def pct(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--url", default="http://127.0.0.1:8080", help="stand-in base URL")
+    ap.add_argument("--records", type=int, default=100, help="records queued before the drain")
+    ap.add_argument("--users", type=int, default=30, help="distinct cards")
+    ap.add_argument("--gap-s", type=int, default=60, help="seconds between synthetic taps")
+    ap.add_argument("--schema", type=int, default=1, choices=(1, 2), help="ATTENDANCE_SCHEMA_VERSION")
+    ap.add_argument("--utc-offset", type=int, default=8, help="GMT_OFFSET_SEC in hours")
+    ap.add_argument("--timeout-s", type=float, default=10, help="per-request timeout")
+    ap.add_argument("--retry-s", type=float, default=0.05, help="wait after a failed request")
+    ap.add_argument("--stream", action="store_true", help="watch /users while draining")
+    ap.add_argument("--stall-s", type=float, default=60, help="silent stream = stalled (STREAM_STALL_TIMEOUT_MS)")
+    ap.add_argument("--check", action="store_true", help="verify the tree afterwards; exit 1 on mismatch")
+    opts = ap.parse_args()
+
+    stats = {"drained": 0, "push_failures": 0, "rollup_failures": 0, "rollup_denied": 0, "push_ms": [],
+             "subscribes": 0, "stream_events": 0, "catchup_ms": []}
+    db = Rtdb(opts.url, opts.timeout_s)
+    queue = make_queue(opts)
+    expected = [dict(r) for r in queue]
+
+    stop = threading.Event()
+    if opts.stream:
+        threading.Thread(target=watch_stream, args=(opts.url, opts, stats, stop), daemon=True).start()
+
+    t0 = time.monotonic()
+    drain(db, queue, opts, stats)
+    elapsed = time.monotonic() - t0
+    stop.set()
+
+    print("Drained %d records in %.2f s (%.1f records/s)" % (stats["drained"], elapsed, stats["drained"] / elapsed))
+    print("Push latency: p50 %.1f ms, p95 %.1f ms, max %.1f ms" % (
+        pct(stats["push_ms"], 50), pct(stats["push_ms"], 95), pct(stats["push_ms"], 100)))
+    print("Retries: push %d, rollup %d (rollups already recorded: %d)" % (
+        stats["push_failures"], stats["rollup_failures"], stats["rollup_denied"]))
+    if opts.stream:
+        print("Stream: %d subscribes, %d events, catch-up p50 %.1f ms, max %.1f ms" % (
+            stats["subscribes"], stats["stream_events"],
+            pct(stats["catchup_ms"], 50), pct(stats["catchup_ms"], 100)))
+
+    if opts.check:
+        errors = check(db, opts, expected)
+        for e in errors:
+            print("FAIL " + e)
+        print("Check: %s" % ("FAIL" if errors else "OK"))
+        return 1 if errors else 0
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())